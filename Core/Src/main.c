@@ -25,6 +25,7 @@
 /* Demo includes. */
 #include "logger.h"
 #include "dwt.h"
+#include "uart_tx.h"
 
 /* Application includes. */
 #include "app.h"
@@ -50,6 +51,7 @@
 TIM_HandleTypeDef htim2;
 
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_tx;
 
 osThreadId defaultTaskHandle;
 /* USER CODE BEGIN PV */
@@ -60,6 +62,7 @@ volatile unsigned long ulHighFrequencyTimerTicks;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
 static void MX_TIM2_Init(void);
 void StartDefaultTask(void const * argument);
@@ -70,7 +73,9 @@ void StartDefaultTask(void const * argument);
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+#if 1 == LOGGER_CONFIG_USE_SEMIHOSTING
 extern void initialise_monitor_handles(void);
+#endif
 
 /* USER CODE END 0 */
 
@@ -82,7 +87,9 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
+#if 1 == LOGGER_CONFIG_USE_SEMIHOSTING
   initialise_monitor_handles();
+#endif
 
   /* USER CODE END 1 */
 
@@ -104,12 +111,16 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
   MX_TIM2_Init();
   /* USER CODE BEGIN 2 */
   /* Start timer */
 	HAL_TIM_Base_Start_IT(&htim2);
 
+    /* Log and printf transport */
+	uart_tx_init(&huart2);
+
     /* add application, ... */
 	app_init();
 
@@ -285,6 +296,22 @@ static void MX_USART2_UART_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Stream6_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : heap_slab.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+/*
+ * pvPortMalloc()/vPortFree() over fixed size classes, one memory_pool_t per
+ * class. A request is served by the smallest class that fits, or by the next
+ * larger one if that class is empty, so both calls are O(number of classes)
+ * and there is no external fragmentation. Use instead of heap_4.c.
+ *
+ * The classes are carved out of ucHeap in order, so vPortFree() finds the
+ * class of a block from its address.
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "memory_pool.h"
+#include "atomic_ops.h"
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+/********************** macros and definitions *******************************/
+
+/*
+ * X(block size, number of blocks), smallest first. Sizes must be multiples of
+ * portBYTE_ALIGNMENT. Tuned for this application:
+ *   128: TCBs (~100 B), queues and mutexes with their storage
+ *   512: 128 word task stacks
+ *  1024: 256 word task stacks (logger, journal)
+ */
+#ifndef configSLAB_CLASSES
+#define configSLAB_CLASSES(X) \
+  X(32,   8) \
+  X(64,   8) \
+  X(128,  16) \
+  X(256,  4) \
+  X(512,  8) \
+  X(1024, 4)
+#endif
+
+#define CLASS_COUNT_(size, nblocks)       + 1
+#define CLASS_BYTES_(size, nblocks)       + MEMORY_POOL_SIZE((nblocks), (size))
+#define CLASS_ENTRY_(size, nblocks)       { (size), (nblocks) },
+
+#define CLASSES_                  (0 configSLAB_CLASSES(CLASS_COUNT_))
+#define CLASSES_BYTES_            (0 configSLAB_CLASSES(CLASS_BYTES_))
+
+_Static_assert(CLASSES_BYTES_ <= configTOTAL_HEAP_SIZE, "configSLAB_CLASSES doesn't fit in configTOTAL_HEAP_SIZE");
+
+/********************** internal data declaration ****************************/
+
+typedef struct
+{
+  size_t block_size;
+  size_t nblocks;
+} slab_class_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+static const slab_class_t class_[CLASSES_] = { configSLAB_CLASSES(CLASS_ENTRY_) };
+
+static memory_pool_t pool_[CLASSES_];
+static uint8_t* pclass_end_[CLASSES_];
+static volatile uint32_t free_bytes_ = 0;
+static volatile uint32_t min_free_bytes_ = 0;
+static volatile uint32_t init_done_ = 0;
+
+#if( configAPPLICATION_ALLOCATED_HEAP == 1 )
+	extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+	static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ] __attribute__((aligned(portBYTE_ALIGNMENT)));
+#endif
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void slab_init_(void)
+{
+  uint8_t* pmemory = ucHeap;
+  uint32_t free_bytes = 0;
+  for(size_t i = 0; i < CLASSES_; ++i)
+  {
+    configASSERT(0 == (class_[i].block_size % portBYTE_ALIGNMENT));
+    memory_pool_init(&pool_[i], pmemory, class_[i].nblocks, class_[i].block_size);
+    pmemory += MEMORY_POOL_SIZE(class_[i].nblocks, class_[i].block_size);
+    pclass_end_[i] = pmemory;
+    free_bytes += class_[i].block_size * class_[i].nblocks;
+  }
+  free_bytes_ = free_bytes;
+  min_free_bytes_ = free_bytes;
+}
+
+static void min_free_update_(uint32_t free_bytes)
+{
+  uint32_t min_free;
+  do
+  {
+    min_free = min_free_bytes_;
+    if(min_free <= free_bytes)
+    {
+      return;
+    }
+  } while(!atomic_ops_cas_u32(&min_free_bytes_, min_free, free_bytes));
+}
+
+/********************** external functions definition ************************/
+
+void* pvPortMalloc(size_t xWantedSize)
+{
+  void* pvReturn = NULL;
+
+  /* the first call comes from xTaskCreate/xQueueCreate before the scheduler runs */
+  if(0 == init_done_)
+  {
+    vTaskSuspendAll();
+    if(0 == init_done_)
+    {
+      slab_init_();
+      init_done_ = 1;
+    }
+    (void)xTaskResumeAll();
+  }
+
+  for(size_t i = 0; (0 < xWantedSize) && (i < CLASSES_); ++i)
+  {
+    if(xWantedSize <= class_[i].block_size)
+    {
+      pvReturn = memory_pool_block_get(&pool_[i]);
+      if(NULL != pvReturn)
+      {
+        uint32_t free_bytes = atomic_ops_add_u32(&free_bytes_, -(uint32_t)class_[i].block_size);
+        min_free_update_(free_bytes);
+        break;
+      }
+    }
+  }
+  traceMALLOC(pvReturn, xWantedSize);
+
+#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+  if(NULL == pvReturn)
+  {
+    extern void vApplicationMallocFailedHook( void );
+    vApplicationMallocFailedHook();
+  }
+#endif
+
+  return pvReturn;
+}
+
+void vPortFree(void* pv)
+{
+  if(NULL == pv)
+  {
+    return;
+  }
+
+  for(size_t i = 0; i < CLASSES_; ++i)
+  {
+    if((uint8_t*)pv < pclass_end_[i])
+    {
+      configASSERT(ucHeap <= (uint8_t*)pv);
+      traceFREE(pv, class_[i].block_size);
+      memory_pool_block_put(&pool_[i], pv);
+      atomic_ops_add_u32(&free_bytes_, (uint32_t)class_[i].block_size);
+      return;
+    }
+  }
+  configASSERT(0);
+}
+
+size_t xPortGetFreeHeapSize(void)
+{
+  return free_bytes_;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void)
+{
+  return min_free_bytes_;
+}
+
+void vPortInitialiseBlocks(void)
+{
+  /* This just exists to keep the linker quiet. */
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : ao.h
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef AO_H_
+#define AO_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cmsis_os.h"
+
+/********************** macros ***********************************************/
+
+/* largest event an active object takes, the task keeps a copy in its stack */
+#define AO_CONFIG_EVENT_MAX_SIZE        (16)
+
+/*
+ * Declares an active object with a static mailbox of queue_len events of
+ * event_type and a static stack of stack_depth words. Start it with ao_start().
+ */
+#define AO_DEFINE(name, task_name_, event_type_, queue_len_, stack_depth_) \
+  _Static_assert(sizeof(event_type_) <= AO_CONFIG_EVENT_MAX_SIZE, #event_type_ " is larger than AO_CONFIG_EVENT_MAX_SIZE"); \
+  static uint8_t name##_queue_storage_[(queue_len_) * sizeof(event_type_)]; \
+  static StackType_t name##_stack_[(stack_depth_)]; \
+  static ao_t name = { \
+    .pname = (task_name_), \
+    .pqueue_storage = name##_queue_storage_, \
+    .queue_len = (queue_len_), \
+    .event_size = sizeof(event_type_), \
+    .pstack = name##_stack_, \
+    .stack_depth = (stack_depth_), \
+  }
+
+/********************** typedef **********************************************/
+
+typedef struct ao_s ao_t;
+
+/* runs to completion in the active object's task, pevent is a copy in its stack */
+typedef void (*ao_dispatch_t)(ao_t* hao, const void* pevent);
+
+/* called by ao_stop() for each event still in the mailbox, to release what it holds */
+typedef void (*ao_drop_t)(ao_t* hao, const void* pevent);
+
+typedef struct
+{
+    uint32_t posted;
+    uint32_t post_failed;
+    uint32_t dispatched;
+    uint32_t queue_high_water;      /* events waiting, at most queue_len */
+    uint32_t dispatch_last_cycles;
+    uint32_t dispatch_max_cycles;
+    uint32_t start_cycles;          /* cost of the last ao_start() */
+    uint32_t stop_cycles;           /* cost of the last ao_stop() */
+} ao_stats_t;
+
+struct ao_s
+{
+    const char* pname;
+    uint8_t* pqueue_storage;
+    size_t queue_len;
+    size_t event_size;
+    StackType_t* pstack;
+    uint32_t stack_depth;
+    ao_dispatch_t dispatch;
+    const void* pinit_event;
+    QueueHandle_t hqueue;
+    TaskHandle_t htask;
+    volatile bool busy;             /* an event is out of the mailbox and not yet dispatched */
+    StaticQueue_t queue_buffer;
+    StaticTask_t task_buffer;
+    volatile ao_stats_t stats;
+};
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/*
+ * Creates the mailbox and the task; pinit_event (optional) is dispatched first.
+ * Nothing comes from the heap. While its mailbox is empty the task blocks with
+ * portMAX_DELAY, which parks it in the suspended list: a dormant AO takes no
+ * CPU, not even on the tick.
+ */
+void ao_start(ao_t* hao, ao_dispatch_t dispatch, UBaseType_t priority, const void* pinit_event);
+
+/*
+ * Deletes the task and the mailbox. Pending events go through drop (optional)
+ * first, so references they carry are released. The static storage stays,
+ * ao_start() can run the AO again. Not from the AO itself; posts made while
+ * stopped fail. Other tasks must not be in the middle of an ao_post().
+ * Returns false, and does nothing, while the AO is dispatching (it may be
+ * preempted or blocked mid event): try again later.
+ */
+bool ao_stop(ao_t* hao, ao_drop_t drop);
+
+/* copies the event into the mailbox, never blocks; false if full or stopped */
+bool ao_post(ao_t* hao, const void* pevent);
+
+bool ao_post_from_isr(ao_t* hao, const void* pevent);
+
+void ao_stats(const ao_t* hao, ao_stats_t* pstats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AO_H_ */
+/********************** end of file ******************************************/
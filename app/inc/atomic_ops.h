@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : atomic_ops.h
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef ATOMIC_OPS_H_
+#define ATOMIC_OPS_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+
+/********************** macros ***********************************************/
+
+/********************** typedef **********************************************/
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/*
+ * Lock-free primitives built on the Cortex-M4 exclusive monitor (LDREX/STREX).
+ * The local monitor is cleared on every exception entry/return, so a STREX
+ * only succeeds if nothing (task switch or ISR of any priority) touched the
+ * word since its LDREX. They never mask interrupts.
+ */
+
+static inline bool atomic_ops_cas_u32(volatile uint32_t* paddr, uint32_t expected, uint32_t desired)
+{
+  do
+  {
+    if(expected != __LDREXW(paddr))
+    {
+      __CLREX();
+      return false;
+    }
+  } while(0 != __STREXW(desired, paddr));
+  return true;
+}
+
+static inline uint32_t atomic_ops_add_u32(volatile uint32_t* paddr, uint32_t value)
+{
+  uint32_t result;
+  do
+  {
+    result = __LDREXW(paddr) + value;
+  } while(0 != __STREXW(result, paddr));
+  return result;
+}
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATOMIC_OPS_H_ */
+/********************** end of file ******************************************/
@@ -67,6 +67,7 @@ extern "C" {
 
 #define BUTTON_PRESSED	GPIO_PIN_RESET
 #define BUTTON_HOVER	GPIO_PIN_SET
+#define BUTTON_EXTI_IRQn	EXTI15_10_IRQn
 
 #define LED_A_PIN		LD2_Pin
 #define LED_A_PORT		LD2_GPIO_Port
@@ -78,6 +79,12 @@ extern "C" {
 #define LED_ON			GPIO_PIN_SET
 #define LED_OFF			GPIO_PIN_RESET
 
+#if (BOARD == NUCLEO_F446RE)
+/* LD2 (PA5) is TIM8_CH1N */
+#define LED_PWM_PIN		LD2_Pin
+#define LED_PWM_PORT	LD2_GPIO_Port
+#endif
+
 #endif/* STM32 Nucleo Boards - 144 Pins */
 
 #if ((BOARD == NUCLEO_F429ZI) || (BOARD == NUCLEO_F413ZH))
@@ -91,6 +98,7 @@ extern "C" {
 
 #define BUTTON_PRESSED	GPIO_PIN_SET
 #define BUTTON_HOVER	GPIO_PIN_RESET
+#define BUTTON_EXTI_IRQn	EXTI15_10_IRQn
 
 #define LED_A_PIN		LD1_Pin
 #define LED_A_PORT		LD1_GPIO_Port
@@ -116,6 +124,7 @@ extern "C" {
 
 #define BUTTON_PRESSED	GPIO_PIN_SET
 #define BUTTON_HOVER	GPIO_PIN_RESET
+#define BUTTON_EXTI_IRQn	EXTI0_IRQn
 
 #define LED_A_PIN		LD3_Pin
 #define LED_A_PORT		LD3_GPIO_Port
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : button_gesture.h
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef BUTTON_GESTURE_H_
+#define BUTTON_GESTURE_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "button_scan.h"
+
+/********************** macros ***********************************************/
+
+#define BUTTON_GESTURE_BUTTONS_MAX      (4)     /* ids from button_scan_add() must stay below this */
+#define BUTTON_GESTURE_CLICKS_MAX       (3)
+
+#define BUTTON_GESTURE_CONFIG_DEFAULT \
+  { \
+    .short_ms = 1000, \
+    .long_ms = 2000, \
+    .repeat_ms = 500, \
+    .gap_ms = 250, \
+    .clicks_max = BUTTON_GESTURE_CLICKS_MAX, \
+  }
+
+/********************** typedef **********************************************/
+
+typedef enum
+{
+  BUTTON_GESTURE_CLICK,         /* released before short_ms, no other click within gap_ms */
+  BUTTON_GESTURE_DOUBLE_CLICK,
+  BUTTON_GESTURE_TRIPLE_CLICK,
+  BUTTON_GESTURE_SHORT,         /* still held at short_ms, fired right then */
+  BUTTON_GESTURE_LONG,          /* still held at long_ms, fired right then */
+  BUTTON_GESTURE_REPEAT,        /* every repeat_ms while held after LONG */
+  BUTTON_GESTURE__N,
+} button_gesture_t;
+
+typedef struct
+{
+    uint16_t short_ms;
+    uint16_t long_ms;           /* > short_ms */
+    uint16_t repeat_ms;         /* 0: no autorepeat */
+    uint16_t gap_ms;            /* max release time between clicks of a multi-click */
+    uint8_t clicks_max;         /* 1: CLICK with no wait, up to BUTTON_GESTURE_CLICKS_MAX */
+} button_gesture_config_t;
+
+typedef void (*button_gesture_cb_t)(uint8_t button, button_gesture_t gesture);
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/*
+ * Gesture recognizer fed by button_scan events. Each button runs the same
+ * state table with its own thresholds and its own one-shot timer, so SHORT,
+ * LONG and REPEAT fire the moment a threshold is crossed, not on release.
+ * Input and timer callbacks both run in the timer task.
+ */
+
+void button_gesture_init(button_gesture_cb_t callback);
+
+/*
+ * thresholds may change at any time, they apply from the next transition;
+ * false, and the previous config stays, if button or thresholds are invalid
+ */
+bool button_gesture_config_set(uint8_t button, const button_gesture_config_t* pconfig);
+
+void button_gesture_config_get(uint8_t button, button_gesture_config_t* pconfig);
+
+/* PRESS and RELEASE from button_scan, HOLD is ignored */
+void button_gesture_input(uint8_t button, button_scan_event_t event);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUTTON_GESTURE_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : button_scan.h
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef BUTTON_SCAN_H_
+#define BUTTON_SCAN_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+
+/********************** macros ***********************************************/
+
+#define BUTTON_SCAN_PORTS_MAX           (4)
+#define BUTTON_SCAN_BUTTONS_MAX         (32)
+
+/* sampling period while a button is active; 4 equal samples change the debounced state */
+#define BUTTON_SCAN_PERIOD_MS           (5)
+#define BUTTON_SCAN_HOLD_MS             (2000)
+
+/********************** typedef **********************************************/
+
+typedef enum
+{
+  BUTTON_SCAN_EVENT_PRESS,
+  BUTTON_SCAN_EVENT_RELEASE,
+  BUTTON_SCAN_EVENT_HOLD,       /* pressed for BUTTON_SCAN_HOLD_MS, once per press */
+  BUTTON_SCAN_EVENT__N,
+} button_scan_event_t;
+
+/* cycles: DWT count at the first edge of the change (HOLD: at detection) */
+typedef void (*button_scan_cb_t)(uint8_t button, button_scan_event_t event, uint32_t cycles);
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/*
+ * Debounces every input of a port at once: one IDR read and a 2-bit vertical
+ * counter per pin, so a scan costs the same few cycles per port for 1 or 16
+ * buttons. The scan runs from a software timer only while some input is
+ * pressed or changing; idle, it stops and waits for an EXTI edge.
+ */
+
+void button_scan_init(button_scan_cb_t callback);
+
+/* returns the button id; a pin already added returns the id it got then */
+uint8_t button_scan_add(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState pressed);
+
+/* starts scanning the current state, call after the last button_scan_add() */
+void button_scan_start(void);
+
+/* from the EXTI callback: stamps the edge and wakes the scanner */
+void button_scan_edge_from_isr(uint16_t pin);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUTTON_SCAN_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : crash_log.h
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef CRASH_LOG_H_
+#define CRASH_LOG_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logger.h"
+
+/********************** macros ***********************************************/
+
+/* last printed log records kept in .noinit RAM, must be a power of two */
+#define CRASH_LOG_CONFIG_HISTORY_LEN      (16)
+/* words copied from the faulting stack, above the exception frame */
+#define CRASH_LOG_CONFIG_STACK_WORDS      (16)
+
+/********************** typedef **********************************************/
+
+typedef enum
+{
+  CRASH_LOG_REASON_NONE = 0,
+  CRASH_LOG_REASON_PANIC = 1,
+  CRASH_LOG_REASON_HARDFAULT = 3,
+  CRASH_LOG_REASON_MEMMANAGE = 4,
+  CRASH_LOG_REASON_BUSFAULT = 5,
+  CRASH_LOG_REASON_USAGEFAULT = 6,
+} crash_log_reason_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/* reports the crash of the previous boot (if any) through the logger, call after logger_init */
+void crash_log_init(void);
+
+/* appends a printed record to the history ring */
+void crash_log_record(const logger_record_t* precord);
+
+/* records the reason and the caller, then resets the mcu */
+void crash_log_panic(const char* what) __attribute__((noreturn));
+
+/* branched to from the fault handlers, with LR still holding EXC_RETURN */
+void crash_log_fault_entry(void) __attribute__((naked, noreturn));
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRASH_LOG_H_ */
+/********************** end of file ******************************************/
@@ -45,6 +45,8 @@ extern "C" {
 
 /********************** inclusions *******************************************/
 
+#include <stdint.h>
+
 /********************** macros ***********************************************/
 
 /* init cycle counter */
@@ -110,6 +112,9 @@ extern "C" {
 
 /********************** external functions declaration ***********************/
 
+/* 64-bit cycle counter, kept extended by the FreeRTOS tick hook */
+uint64_t cycle_counter_get_64(void);
+
 /********************** End of CPP guard *************************************/
 #ifdef __cplusplus
 }
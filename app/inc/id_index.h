@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : id_index.h
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef ID_INDEX_H_
+#define ID_INDEX_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/********************** macros ***********************************************/
+
+/* storage for an index of up to capacity - 1 ids, capacity a power of two >= 2 */
+#define ID_INDEX_STORAGE(name, capacity) \
+  _Static_assert((1 < (capacity)) && (0 == ((capacity) & ((capacity) - 1))), "id_index capacity must be a power of two >= 2"); \
+  static id_index_entry_t name[(capacity)]
+
+/********************** typedef **********************************************/
+
+typedef struct
+{
+    uint32_t id;
+    void* pvalue;   /* NULL: empty slot */
+} id_index_entry_t;
+
+/* open addressing, linear probing, deletion by backward shift (no tombstones) */
+typedef struct
+{
+    id_index_entry_t* pentry;
+    uint32_t mask;
+    uint32_t shift;
+    uint32_t count;
+} id_index_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/* false if capacity is not a power of two >= 2 (a capacity of 1 would shift by 32) */
+bool id_index_init(id_index_t* hindex, id_index_entry_t* pstorage, size_t capacity);
+
+/* adds or replaces the value of id (not NULL); false when full, the index is left as it was */
+bool id_index_insert(id_index_t* hindex, uint32_t id, void* pvalue);
+
+void* id_index_find(const id_index_t* hindex, uint32_t id);
+
+/* returns the removed value, NULL if the id wasn't there */
+void* id_index_remove(id_index_t* hindex, uint32_t id);
+
+uint32_t id_index_count(const id_index_t* hindex);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ID_INDEX_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : journal.h
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/********************** macros ***********************************************/
+
+/* events waiting in RAM to be written */
+#define JOURNAL_CONFIG_QUEUE_LEN          (16)
+/* time the task waits after the first event so the rest are written in the same batch */
+#define JOURNAL_CONFIG_BATCH_MS           (500)
+#define JOURNAL_CONFIG_TASK_STACK_SIZE    (256)
+/* the last value of every event is rewritten after this many records, bounds the boot scan */
+#define JOURNAL_CONFIG_SNAPSHOT_PERIOD    (128)
+/* the spare sector is erased only after this long without events */
+#define JOURNAL_CONFIG_IDLE_MS            (2000)
+
+/********************** typedef **********************************************/
+
+typedef enum
+{
+  JOURNAL_EVENT_BUTTON,   /* value: msg_event_t */
+  JOURNAL_EVENT_LED,      /* value: bit n set if led ao_led_color n is on */
+  JOURNAL_EVENT__N,
+} journal_event_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/*
+ * The F446 has a single flash bank: while a sector erases, instruction fetch
+ * stalls, ISRs included. The journal uses 16K sectors (erase 250 ms typical,
+ * 500 ms max at x32) and erases the spare one ahead of time, once no event
+ * came for JOURNAL_CONFIG_IDLE_MS, i.e. in a pause of the user. The erase
+ * runs inline, stalling up to 500 ms, only on the first boot or if a sector
+ * fills (~2000 records) without such a pause since the last switch.
+ * Programming a record stalls about 32 us.
+ */
+
+/* scans the journal sectors and loads the last value of every event */
+void journal_init(void);
+
+/* never blocks, the record is written later by the journal task */
+bool journal_append(journal_event_t event, uint8_t value);
+
+/* last value of the event, false if it was never written */
+bool journal_last(journal_event_t event, uint8_t* pvalue);
+
+uint32_t journal_dropped(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JOURNAL_H_ */
+/********************** end of file ******************************************/
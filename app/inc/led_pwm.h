@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : led_pwm.h
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef LED_PWM_H_
+#define LED_PWM_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+#include "board.h"
+
+/********************** macros ***********************************************/
+
+/* brightness levels, 0 is off; a gamma 2.2 table maps them to compare values */
+#define LED_PWM_LEVELS                  (256)
+#define LED_PWM_LEVEL_MAX               (LED_PWM_LEVELS - 1)
+
+/* PWM period in timer ticks of 1 us: 1 kHz */
+#define LED_PWM_PERIOD                  (1000)
+
+/* table steps of a ramp; with the 8-bit repetition counter a ramp lasts up to 64 * 256 ms */
+#define LED_PWM_RAMP_STEPS_MAX          (64)
+#define LED_PWM_RAMP_MS_MAX             (LED_PWM_RAMP_STEPS_MAX * 256)
+
+/********************** typedef **********************************************/
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/*
+ * LED output backend on timer PWM (LED_PWM_PORT/LED_PWM_PIN in board.h).
+ * Ramps are compare-value tables fed to the timer by DMA on every update
+ * event, the repetition counter sets the step length: once started a fade
+ * costs no CPU and no interrupt. Boards without a PWM capable LED pin get
+ * stubs that return false.
+ *
+ * Not thread safe, one owner (the LED active object).
+ */
+
+/* true if the LED pin has a PWM backend */
+bool led_pwm_init(void);
+
+/* true while the timer drives the pin, false while it is a plain GPIO */
+bool led_pwm_attached(void);
+
+/* sets the level at once, attaches the pin */
+bool led_pwm_set(uint8_t level);
+
+/* fades from the current level to level in ms, attaches the pin */
+bool led_pwm_ramp(uint8_t level, uint32_t ms);
+
+/* fades up and down in a loop until another call, attaches the pin */
+bool led_pwm_breathe(uint8_t level, uint32_t period_ms);
+
+/* stops any ramp and gives the pin back to GPIO output, it keeps its output latch */
+void led_pwm_detach(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LED_PWM_H_ */
+/********************** end of file ******************************************/
@@ -43,11 +43,30 @@ extern "C" {
 /********************** inclusions *******************************************/
 
 #include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
 /********************** macros ***********************************************/
 
+/*
+ * struct holding the node, e.g. with
+ *   typedef struct { uint32_t id; linked_list_node_t node; } item_t;
+ * LINKED_LIST_CONTAINER_OF(hnode, item_t, node) gives the item_t of hnode
+ */
+#define LINKED_LIST_CONTAINER_OF(hnode, type, member) \
+  ((type*)((uint8_t*)(hnode) - offsetof(type, member)))
+
+/* same, but NULL stays NULL; hnode is evaluated once, e.g. linked_list_node_remove() */
+#define LINKED_LIST_ENTRY(hnode, type, member) \
+  ((type*)linked_list_entry_((hnode), offsetof(type, member)))
+
+/* hnode may be unlinked (or freed) in the body, hnext is read before it runs */
+#define LINKED_LIST_FOREACH_SAFE(hlist, hnode, hnext) \
+  for((hnode) = (hlist)->pfirst_node, (hnext) = (NULL == (hnode)) ? NULL : (hnode)->pnext_node; \
+      NULL != (hnode); \
+      (hnode) = (hnext), (hnext) = (NULL == (hnode)) ? NULL : (hnode)->pnext_node)
+
 /********************** typedef **********************************************/
 
 typedef struct linked_list_node_s linked_list_node_t;
@@ -59,25 +78,41 @@ typedef struct
     size_t len;
 } linked_list_t;
 
+/* intrusive: embed it in the struct to be listed, a node is in one list at a time */
 struct linked_list_node_s
 {
-    void* pdata;
     linked_list_node_t* pnext_node;
+    linked_list_node_t* pprev_node;
 };
 
+static inline void* linked_list_entry_(linked_list_node_t* hnode, size_t offset)
+{
+  return (NULL == hnode) ? NULL : (void*)((uint8_t*)hnode - offset);
+}
+
 /********************** external data declaration ****************************/
 
 /********************** external functions declaration ***********************/
 
 void linked_list_init(linked_list_t* hlist);
 
-void linked_list_node_init(linked_list_node_t* hnode, void* pdata);
+void linked_list_node_init(linked_list_node_t* hnode);
 
+/* removes the first node, NULL if empty */
 linked_list_node_t* linked_list_node_remove(linked_list_t* hlist);
 
+/* appends at the end */
 void linked_list_node_add(linked_list_t* hlist, linked_list_node_t* hnode);
 
-linked_list_node_t* linked_list_node_remove_by_id(linked_list_t* hlist, int id);
+void linked_list_node_insert_after(linked_list_t* hlist, linked_list_node_t* hpos, linked_list_node_t* hnode);
+
+void linked_list_node_insert_before(linked_list_t* hlist, linked_list_node_t* hpos, linked_list_node_t* hnode);
+
+/* O(1), hnode must be in hlist */
+void linked_list_node_unlink(linked_list_t* hlist, linked_list_node_t* hnode);
+
+/* moves every node of hsrc to the end of hlist, hsrc ends up empty */
+void linked_list_splice(linked_list_t* hlist, linked_list_t* hsrc);
 
 /********************** End of CPP guard *************************************/
 #ifdef __cplusplus
@@ -52,37 +52,145 @@ extern "C" {
 /********************** macros ***********************************************/
 
 #define LOGGER_CONFIG_ENABLE                    (1)
-#define LOGGER_CONFIG_MAXLEN                    (64)
-#define LOGGER_CONFIG_USE_SEMIHOSTING           (1)
+#define LOGGER_CONFIG_MAXLEN                    (128)
+#define LOGGER_CONFIG_USE_UART                  (1)
+#define LOGGER_CONFIG_USE_SEMIHOSTING           (0) // needs -specs=rdimon.specs -lrdimon and Core/Src/syscalls.c excluded
+#define LOGGER_CONFIG_MAXARGS                   (4)
+#define LOGGER_CONFIG_QUEUE_LEN                 (32) // must be a power of two
+#define LOGGER_CONFIG_TASK_IDLE_MS              (100) // wake-up bound for records that could not notify the task
+#define LOGGER_CONFIG_TASK_STACK_SIZE           (256)
+#define LOGGER_CONFIG_USE_TOKENS                (0)
+
+/*
+ * LOGGER_LOG only copies the format pointer and up to LOGGER_CONFIG_MAXARGS
+ * argument words into the record queue; the logger task formats them later.
+ * Arguments must be 32-bit integers or pointers, and "%s" strings must still
+ * be alive when the record is printed (string literals, const tables).
+ */
+#define LOGGER_NARGS_SEL_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15,\
+                          _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, N, ...)   N
+/* counts up to 31 arguments after the format, far past LOGGER_CONFIG_MAXARGS so the assert below catches any excess */
+#define LOGGER_NARGS_(...)  LOGGER_NARGS_SEL_(__VA_ARGS__, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16,\
+                                              15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0)
+
+#define LOGGER_FMT_(fmt, ...)   fmt
+#define LOGGER_ARGS_(fmt, ...)  , ##__VA_ARGS__
+
+/*
+ * Tokenized mode: the format string is stored in the ".logger_fmt" linker
+ * section, which is never loaded to the target. Its offset in that section
+ * is the token sent on the wire instead of the text, and
+ * tools/logger_decode.py rebuilds the line from the ELF file.
+ */
+#if 1 == LOGGER_CONFIG_USE_TOKENS
+#define LOGGER_FMT_DEFINE_(name, ...)\
+    static const char name[] __attribute__((section(".logger_fmt"), used)) = LOGGER_FMT_(__VA_ARGS__)
+#define LOGGER_FMT_REF_(name, ...)  name LOGGER_ARGS_(__VA_ARGS__)
+#else
+#define LOGGER_FMT_DEFINE_(name, ...)
+#define LOGGER_FMT_REF_(name, ...)  __VA_ARGS__
+#endif
 
 #if 1 == LOGGER_CONFIG_ENABLE
 #define LOGGER_LOG(...)\
-    taskENTER_CRITICAL();\
+    do\
     {\
-        logger_msg_len = snprintf(logger_msg, (LOGGER_CONFIG_MAXLEN - 1), __VA_ARGS__);\
-        logger_log_print_(logger_msg);\
-    }\
-    taskEXIT_CRITICAL()
+        _Static_assert(LOGGER_NARGS_(__VA_ARGS__) <= LOGGER_CONFIG_MAXARGS, "LOGGER_LOG: too many arguments");\
+        LOGGER_FMT_DEFINE_(logger_fmt_, __VA_ARGS__);\
+        logger_log_(LOGGER_NARGS_(__VA_ARGS__), LOGGER_FMT_REF_(logger_fmt_, __VA_ARGS__));\
+    } while(0)
 #else
-#define LOGGER_LOG(...)
+#define LOGGER_LOG(...)                         do {} while(0)
+#endif
+
+/*
+ * Levels. Each module may set LOGGER_MODULE_LEVEL before including logger.h,
+ * otherwise LOGGER_CONFIG_LEVEL applies. Statements above the module level
+ * expand to nothing, so their arguments are never evaluated. Enabled ones
+ * emit a single record with the prefix and newline folded into the format.
+ */
+#define LOGGER_LEVEL_NONE                       (0)
+#define LOGGER_LEVEL_ERROR                      (1)
+#define LOGGER_LEVEL_WARN                       (2)
+#define LOGGER_LEVEL_INFO                       (3)
+#define LOGGER_LEVEL_DEBUG                      (4)
+#define LOGGER_LEVEL_TRACE                      (5)
+
+#define LOGGER_CONFIG_LEVEL                     (LOGGER_LEVEL_INFO)
+
+#ifndef LOGGER_MODULE_LEVEL
+#define LOGGER_MODULE_LEVEL                     LOGGER_CONFIG_LEVEL
 #endif
 
-#define LOGGER_INFO(...)\
-    LOGGER_LOG("[info] ");\
-    LOGGER_LOG(__VA_ARGS__);\
-    LOGGER_LOG("\n");
+#define LOGGER_LEVEL_LOG_(prefix, fmt, ...)     LOGGER_LOG(prefix fmt "\n", ##__VA_ARGS__)
+#define LOGGER_LEVEL_OFF_(...)                  do {} while(0)
+
+#if LOGGER_LEVEL_ERROR <= LOGGER_MODULE_LEVEL
+#define LOGGER_ERROR(...)   LOGGER_LEVEL_LOG_("[error] ", __VA_ARGS__)
+#else
+#define LOGGER_ERROR(...)   LOGGER_LEVEL_OFF_(__VA_ARGS__)
+#endif
+
+#if LOGGER_LEVEL_WARN <= LOGGER_MODULE_LEVEL
+#define LOGGER_WARN(...)    LOGGER_LEVEL_LOG_("[warn] ", __VA_ARGS__)
+#else
+#define LOGGER_WARN(...)    LOGGER_LEVEL_OFF_(__VA_ARGS__)
+#endif
+
+#if LOGGER_LEVEL_INFO <= LOGGER_MODULE_LEVEL
+#define LOGGER_INFO(...)    LOGGER_LEVEL_LOG_("[info] ", __VA_ARGS__)
+#else
+#define LOGGER_INFO(...)    LOGGER_LEVEL_OFF_(__VA_ARGS__)
+#endif
+
+#if LOGGER_LEVEL_DEBUG <= LOGGER_MODULE_LEVEL
+#define LOGGER_DEBUG(...)   LOGGER_LEVEL_LOG_("[debug] ", __VA_ARGS__)
+#else
+#define LOGGER_DEBUG(...)   LOGGER_LEVEL_OFF_(__VA_ARGS__)
+#endif
+
+#if LOGGER_LEVEL_TRACE <= LOGGER_MODULE_LEVEL
+#define LOGGER_TRACE(...)   LOGGER_LEVEL_LOG_("[trace] ", __VA_ARGS__)
+#else
+#define LOGGER_TRACE(...)   LOGGER_LEVEL_OFF_(__VA_ARGS__)
+#endif
 
 #define GET_NAME(var)  #var
 
 /********************** typedef **********************************************/
 
-extern char* const logger_msg;
-extern int logger_msg_len; // only for debug information
+/*
+ * timestamp: 64-bit DWT cycle count taken at the call site.
+ * context: exception number when logged from an ISR, otherwise the handle
+ * of the calling task (0 before the scheduler starts).
+ */
+typedef struct
+{
+    uint64_t timestamp;
+    uint32_t context;
+    const char* fmt;
+    uint32_t nargs;
+    uint32_t args[LOGGER_CONFIG_MAXARGS];
+} logger_record_t;
 
 /********************** external functions declaration ***********************/
 
+void logger_init(void);
+
+bool logger_log_(uint32_t nargs, const char* fmt, ...);
+
+bool logger_replay(const logger_record_t* precord);
+
+void logger_pending_foreach(void (*callback)(const logger_record_t*));
+
+uint32_t logger_dropped(void);
+
+uint32_t logger_context_get(void);
+
 void logger_log_print_(char* const msg);
 
+void logger_log_write_(const void* data, size_t len);
+
 /********************** End of CPP guard *************************************/
 #ifdef __cplusplus
 }
@@ -47,31 +47,163 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 
-#include "linked_list.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
 
 /********************** macros ***********************************************/
 
+/* 1: the block header also records the allocating task and a timestamp */
+#define MEMORY_POOL_CONFIG_DEBUG                 (0)
+
+/* blocks a per task magazine holds, half of them move to/from the pool at once */
+#define MEMORY_POOL_CONFIG_MAGAZINE_SIZE         (8)
+/* FreeRTOS thread local storage slot of the magazine */
+#define MEMORY_POOL_TLS_INDEX                    (0)
+
+#if MEMORY_POOL_TLS_INDEX >= configNUM_THREAD_LOCAL_STORAGE_POINTERS
+#error "memory_pool magazines need configNUM_THREAD_LOCAL_STORAGE_POINTERS > MEMORY_POOL_TLS_INDEX"
+#endif
+
 /********************** typedef **********************************************/
 
+typedef struct memory_pool_block_s memory_pool_block_t;
+
+struct memory_pool_block_s
+{
+    memory_pool_block_t* pnext;
+};
+
+/* in front of every block, a multiple of 8 bytes so blocks stay aligned */
+typedef struct
+{
+    volatile uint32_t refs;   /* 0 while the block is free */
+#if 1 == MEMORY_POOL_CONFIG_DEBUG
+    uint32_t timestamp;       /* HAL_GetTick() at allocation */
+    void* owner;              /* allocating task handle, NULL from an ISR */
+#endif
+    uint32_t reserved;
+} memory_pool_header_t;
+
+#define MEMORY_POOL_HEADER_SIZE                  (sizeof(memory_pool_header_t))
+
 typedef struct
 {
-    linked_list_t block_list;
+    uint32_t nblocks;
+    uint32_t in_use;
+    uint32_t high_water;
+    uint32_t gets;
+    uint32_t puts;
+    uint32_t failed;
+    uint32_t waiters;
+} memory_pool_stats_t;
+
+/*
+ * Free blocks form a Treiber stack, the link lives in the free block itself.
+ * Blocks never handed out yet are bump allocated from pfresh, so a pool needs
+ * no setup loop and can be initialized at compile time.
+ */
+typedef struct
+{
+    memory_pool_block_t* volatile ptop;
+    uint8_t* volatile pfresh;
+    uint8_t* pend;
+    uint8_t* pmemory;
+    size_t stride;
+    volatile uint32_t nblocks;
+    volatile uint32_t in_use;
+    volatile uint32_t high_water;
+    volatile uint32_t gets;
+    volatile uint32_t puts;
+    volatile uint32_t failed;
+    volatile uint32_t waiters;
+    SemaphoreHandle_t hsem;   /* NULL unless memory_pool_blocking_init() */
 } memory_pool_t;
 
-typedef linked_list_node_t memory_pool_block_t;
+/* free blocks cached by one task, touched only by that task */
+typedef struct
+{
+    memory_pool_t* hmp;
+    uint32_t count;
+    void* pblock[MEMORY_POOL_CONFIG_MAGAZINE_SIZE];
+} memory_pool_magazine_t;
+
+#define MEMORY_POOL_ALIGN                        (8)
+#define MEMORY_POOL_BLOCK_STRIDE(block_size)     (MEMORY_POOL_HEADER_SIZE + (((block_size) + MEMORY_POOL_ALIGN - 1) & ~(size_t)(MEMORY_POOL_ALIGN - 1)))
+#define MEMORY_POOL_SIZE(nblocks, block_size)    ((nblocks) * MEMORY_POOL_BLOCK_STRIDE(block_size))
+
+#define MEMORY_POOL_INITIALIZER(pmemory_, nblocks_, block_size_) \
+  { \
+    .ptop = NULL, \
+    .pfresh = (uint8_t*)(pmemory_), \
+    .pend = (uint8_t*)(pmemory_) + MEMORY_POOL_SIZE((nblocks_), (block_size_)), \
+    .pmemory = (uint8_t*)(pmemory_), \
+    .stride = MEMORY_POOL_BLOCK_STRIDE(block_size_), \
+    .nblocks = (nblocks_), \
+  }
 
-#define MEMORY_POOL_SIZE(nblocks, block_size)    ((nblocks)*(block_size))
+/*
+ * Statically defines a pool of nblocks objects of type, storage sized and 8
+ * byte aligned at compile time, ready to use without memory_pool_init().
+ * The storage can be placed in a given linker section, e.g. ".noinit".
+ */
+#define MEMORY_POOL_DEFINE_SECTION(name, type, nblocks, section) \
+  _Static_assert(sizeof(type) >= sizeof(memory_pool_block_t), #type " is smaller than memory_pool_block_t"); \
+  static uint64_t name##_memory_[MEMORY_POOL_SIZE((nblocks), sizeof(type)) / sizeof(uint64_t)] __attribute__((section(section))); \
+  static memory_pool_t name = MEMORY_POOL_INITIALIZER(name##_memory_, (nblocks), sizeof(type))
+
+#define MEMORY_POOL_DEFINE(name, type, nblocks) \
+  _Static_assert(sizeof(type) >= sizeof(memory_pool_block_t), #type " is smaller than memory_pool_block_t"); \
+  static uint64_t name##_memory_[MEMORY_POOL_SIZE((nblocks), sizeof(type)) / sizeof(uint64_t)]; \
+  static memory_pool_t name = MEMORY_POOL_INITIALIZER(name##_memory_, (nblocks), sizeof(type))
 
 /********************** external data declaration ****************************/
 
 /********************** external functions declaration ***********************/
 
-void memory_pool_init(memory_pool_t* hmp, void* pmemory, size_t memory_size, size_t block_size);
+/* pmemory must be MEMORY_POOL_ALIGN aligned and MEMORY_POOL_SIZE() bytes long */
+void memory_pool_init(memory_pool_t* hmp, void* pmemory, size_t nblocks, size_t block_size);
+
+/* enables memory_pool_block_get_timeout(), psem_buffer must outlive the pool */
+void memory_pool_blocking_init(memory_pool_t* hmp, StaticSemaphore_t* psem_buffer);
 
+/* try mode: lock-free, never blocks, safe from tasks and from ISRs of any priority.
+ * The block comes with one reference. */
 void* memory_pool_block_get(memory_pool_t* hmp);
 
+/* tasks only: waits up to timeout ticks for a block to be put back */
+void* memory_pool_block_get_timeout(memory_pool_t* hmp, TickType_t timeout);
+
+/*
+ * Lock-free, returns the block whatever its references. If tasks are waiting
+ * for a block it also gives the semaphore, then it must not be called from
+ * ISRs above configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ */
 void memory_pool_block_put(memory_pool_t* hmp, void* pblock);
 
+/* takes one more reference, for each extra consumer the block is posted to */
+void memory_pool_block_ref(void* pblock);
+
+/* drops one reference, the last one puts the block back; true if it did */
+bool memory_pool_block_release(memory_pool_t* hmp, void* pblock);
+
+/*
+ * Gives the calling task a magazine for hmp: from then on its gets and puts
+ * on hmp are served from the magazine, and the shared pool is only touched
+ * to exchange half a magazine at a time. Detach before the task is deleted.
+ */
+void memory_pool_magazine_attach(memory_pool_t* hmp, memory_pool_magazine_t* pmagazine);
+
+/* returns the cached blocks to the pool */
+void memory_pool_magazine_detach(void);
+
+/* snapshot of the counters, each one is read atomically */
+void memory_pool_stats(const memory_pool_t* hmp, memory_pool_stats_t* pstats);
+
+#if 1 == MEMORY_POOL_CONFIG_DEBUG
+/* calls callback for every block currently allocated */
+void memory_pool_foreach_used(const memory_pool_t* hmp, void (*callback)(const void* pblock, const memory_pool_header_t* pheader));
+#endif
+
 /********************** End of CPP guard *************************************/
 #ifdef __cplusplus
 }
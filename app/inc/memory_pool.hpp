@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : memory_pool.hpp
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef MEMORY_POOL_HPP_
+#define MEMORY_POOL_HPP_
+
+/********************** inclusions *******************************************/
+
+#include <cstddef>
+#include <cstdint>
+
+#include "memory_pool.h"
+
+/********************** macros ***********************************************/
+
+/********************** typedef **********************************************/
+
+/*
+ * C++ counterpart of MEMORY_POOL_DEFINE: N blocks of T, storage sized and
+ * aligned at compile time. The constructor is constexpr, so a Pool with static
+ * storage duration is constant initialized, no code runs at startup. Blocks
+ * are raw storage, construct with placement new if T needs it.
+ *
+ *   static Pool<ao_led_message_t, 10> pool;
+ *   ao_led_message_t* pmsg = pool.get();
+ */
+template <typename T, std::size_t N>
+class Pool
+{
+  static_assert(sizeof(T) >= sizeof(memory_pool_block_t), "T is smaller than memory_pool_block_t");
+  static_assert(alignof(T) <= MEMORY_POOL_ALIGN, "T needs more alignment than MEMORY_POOL_ALIGN");
+  static_assert(0 < N, "empty pool");
+
+public:
+  constexpr Pool() :
+    pool_{nullptr, storage_, storage_ + sizeof(storage_), storage_, MEMORY_POOL_BLOCK_STRIDE(sizeof(T)), N, 0, 0, 0, 0, 0, 0, nullptr},
+    storage_{}
+  {
+  }
+
+  Pool(const Pool&) = delete;
+  Pool& operator=(const Pool&) = delete;
+
+  T* get()
+  {
+    return static_cast<T*>(memory_pool_block_get(&pool_));
+  }
+
+  T* get(TickType_t timeout)
+  {
+    return static_cast<T*>(memory_pool_block_get_timeout(&pool_, timeout));
+  }
+
+  void put(T* pblock)
+  {
+    memory_pool_block_put(&pool_, pblock);
+  }
+
+  void ref(T* pblock)
+  {
+    memory_pool_block_ref(pblock);
+  }
+
+  bool release(T* pblock)
+  {
+    return memory_pool_block_release(&pool_, pblock);
+  }
+
+  memory_pool_stats_t stats() const
+  {
+    memory_pool_stats_t stats;
+    memory_pool_stats(&pool_, &stats);
+    return stats;
+  }
+
+  memory_pool_t* handle()
+  {
+    return &pool_;
+  }
+
+private:
+  memory_pool_t pool_;
+  alignas(MEMORY_POOL_ALIGN) std::uint8_t storage_[MEMORY_POOL_SIZE(N, sizeof(T))];
+};
+
+#endif /* MEMORY_POOL_HPP_ */
+/********************** end of file ******************************************/
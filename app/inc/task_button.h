@@ -50,7 +50,8 @@ extern "C" {
 
 /********************** external functions declaration ***********************/
 
-void task_button(void* argument);
+/* enables the button interrupt, the UI active object must be running */
+void task_button_init(void);
 
 /********************** End of CPP guard *************************************/
 #ifdef __cplusplus
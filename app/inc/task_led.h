@@ -49,13 +49,21 @@ extern "C" {
 #include "cmsis_os.h"
 /********************** macros ***********************************************/
 
+/* 1: build de diagnostico, la ui para y rearranca el ao de leds al iniciar y loguea lo que cuesta */
+#define AO_LED_CONFIG_RESTART_TEST       (0)
+
 /********************** typedef **********************************************/
 
 typedef enum
 {
   AO_LED_MESSAGE_ON,
   AO_LED_MESSAGE_OFF,
-  AO_LED_MESSAGE_BLINK,
+  AO_LED_MESSAGE_BLINK,     /* value: ms encendido, luego se apaga */
+  AO_LED_MESSAGE_PULSES,    /* value: ms por semiperiodo, count: pulsos (0: hasta otro comando) */
+  AO_LED_MESSAGE_TIMED_OFF, /* value: ms hasta apagarse, el estado actual no cambia */
+  AO_LED_MESSAGE_BRIGHTNESS,/* value: nivel 0..255, ramp_ms: duracion del fundido (0: inmediato) */
+  AO_LED_MESSAGE_BREATHE,   /* value: nivel maximo 0..255, ramp_ms: periodo, hasta otro comando */
+  AO_LED_MESSAGE_SCENE,     /* value: bit n set si el led ao_led_color n queda encendido, color no se usa */
   AO_LED_MESSAGE__N,
 } ao_led_action_t;
 
@@ -66,15 +74,29 @@ typedef enum
   AO_LED_COLOR_RED,
   AO_LED_COLOR_GREEN,
   AO_LED_COLOR_BLUE,
+  AO_LED_COLOR__N,
 } ao_led_color;
 
+/*
+ * Los efectos (BLINK, PULSES, TIMED_OFF) corren con timers, el mensaje se
+ * libera al arrancar el efecto. BRIGHTNESS y BREATHE usan PWM + DMA si el pin
+ * del led lo permite (led_pwm.h), si no se aproximan con encendido/apagado. Cada led tiene a lo sumo un efecto, cualquier
+ * comando nuevo para ese led (o una escena) lo reemplaza.
+ *
+ * Read only once posted, it may be shared; the consumer calls callback when
+ * done. Only cancelled may still change: the producer sets it when a newer
+ * command supersedes this one, the consumer then skips the action.
+ */
 typedef struct
 {
     int id;
     ao_led_cb_t callback;
     ao_led_action_t action;
     int value;
+    int count;
+    int ramp_ms;
     ao_led_color color;
+    volatile bool cancelled;
 } ao_led_message_t;
 
 
@@ -85,6 +107,12 @@ typedef struct
 
 bool ao_led_send(ao_led_message_t* msg);
 void ao_led_init();
+#if 1 == AO_LED_CONFIG_RESTART_TEST
+/* detiene y vuelve a arrancar el ao, los mensajes pendientes se devuelven a su callback; no desde el ao */
+void ao_led_restart(void);
+#endif
+/* comandos a los timers de efectos que no entraron en la cola (se reintentan) */
+uint32_t ao_led_timer_failed(void);
 
 /********************** End of CPP guard *************************************/
 #ifdef __cplusplus
@@ -61,6 +61,9 @@ typedef enum
   MSG_EVENT_BUTTON_PULSE,
   MSG_EVENT_BUTTON_SHORT,
   MSG_EVENT_BUTTON_LONG,
+  MSG_EVENT_BUTTON_DOUBLE,
+  MSG_EVENT_BUTTON_TRIPLE,
+  MSG_EVENT_INIT,           /* dispatched once when the active object starts */
   MSG_EVENT__N,
 } msg_event_t;
 
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : ao.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "dwt.h"
+#include "atomic_ops.h"
+#include "crash_log.h"
+
+#include "ao.h"
+
+/********************** macros and definitions *******************************/
+
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void max_update_(volatile uint32_t* pmax, uint32_t value)
+{
+  uint32_t max;
+  do
+  {
+    max = *pmax;
+    if(value <= max)
+    {
+      return;
+    }
+  } while(!atomic_ops_cas_u32(pmax, max, value));
+}
+
+static void dispatch_(ao_t* hao, const void* pevent)
+{
+  uint32_t cycles = cycle_counter_get();
+  hao->dispatch(hao, pevent);
+  cycles = cycle_counter_get() - cycles;
+
+  hao->stats.dispatched++;
+  hao->stats.dispatch_last_cycles = cycles;
+  max_update_(&hao->stats.dispatch_max_cycles, cycles);
+}
+
+static void task_(void *argument)
+{
+  ao_t* hao = (ao_t*)argument;
+  uint32_t event[(AO_CONFIG_EVENT_MAX_SIZE + sizeof(uint32_t) - 1) / sizeof(uint32_t)];
+
+  if(NULL != hao->pinit_event)
+  {
+    dispatch_(hao, hao->pinit_event);
+  }
+
+  while(true)
+  {
+    /* the event stays in the mailbox until busy is set, so ao_stop() either drops it or waits */
+    hao->busy = false;
+    if(pdPASS == xQueuePeek(hao->hqueue, event, portMAX_DELAY))
+    {
+      hao->busy = true;
+      (void)xQueueReceive(hao->hqueue, event, 0);
+      dispatch_(hao, event);
+    }
+  }
+}
+
+static bool post_done_(ao_t* hao, bool posted, UBaseType_t waiting)
+{
+  if(!posted)
+  {
+    atomic_ops_add_u32(&hao->stats.post_failed, 1);
+    return false;
+  }
+  atomic_ops_add_u32(&hao->stats.posted, 1);
+  max_update_(&hao->stats.queue_high_water, waiting);
+  return true;
+}
+
+/********************** external functions definition ************************/
+
+void ao_start(ao_t* hao, ao_dispatch_t dispatch, UBaseType_t priority, const void* pinit_event)
+{
+  if((AO_CONFIG_EVENT_MAX_SIZE < hao->event_size) || (NULL == dispatch))
+  {
+    crash_log_panic("ao_start");
+  }
+
+  uint32_t cycles = cycle_counter_get();
+
+  hao->dispatch = dispatch;
+  hao->pinit_event = pinit_event;
+  hao->stats = (ao_stats_t){.stop_cycles = hao->stats.stop_cycles}; // the cost of a previous ao_stop() stays readable
+
+  hao->hqueue = xQueueCreateStatic(hao->queue_len, hao->event_size, hao->pqueue_storage, &hao->queue_buffer);
+  if(NULL == hao->hqueue)
+  {
+    crash_log_panic("ao_start xQueueCreateStatic");
+  }
+
+  hao->busy = true;
+  hao->htask = xTaskCreateStatic(task_, hao->pname, hao->stack_depth, hao, priority, hao->pstack, &hao->task_buffer);
+  if(NULL == hao->htask)
+  {
+    crash_log_panic("ao_start xTaskCreateStatic");
+  }
+
+  hao->stats.start_cycles = cycle_counter_get() - cycles;
+}
+
+bool ao_stop(ao_t* hao, ao_drop_t drop)
+{
+  if((NULL == hao->htask) || (xTaskGetCurrentTaskHandle() == hao->htask))
+  {
+    crash_log_panic("ao_stop");
+  }
+
+  uint32_t cycles = cycle_counter_get();
+
+  /* the AO cannot run between the check and the delete */
+  vTaskSuspendAll();
+  if(hao->busy)
+  {
+    (void)xTaskResumeAll();
+    return false;
+  }
+  QueueHandle_t hqueue = hao->hqueue;
+  hao->hqueue = NULL;
+  vTaskDelete(hao->htask);
+  hao->htask = NULL;
+  (void)xTaskResumeAll();
+
+  uint32_t event[(AO_CONFIG_EVENT_MAX_SIZE + sizeof(uint32_t) - 1) / sizeof(uint32_t)];
+  while(pdPASS == xQueueReceive(hqueue, event, 0))
+  {
+    if(NULL != drop)
+    {
+      drop(hao, event);
+    }
+  }
+  vQueueDelete(hqueue);
+
+  hao->stats.stop_cycles = cycle_counter_get() - cycles;
+  return true;
+}
+
+bool ao_post(ao_t* hao, const void* pevent)
+{
+  QueueHandle_t hqueue = hao->hqueue;
+  bool posted = (NULL != hqueue) && (pdPASS == xQueueSend(hqueue, pevent, 0));
+  return post_done_(hao, posted, posted ? uxQueueMessagesWaiting(hqueue) : 0);
+}
+
+bool ao_post_from_isr(ao_t* hao, const void* pevent)
+{
+  BaseType_t higher_priority_task_woken = pdFALSE;
+  QueueHandle_t hqueue = hao->hqueue;
+  bool posted = (NULL != hqueue) && (pdPASS == xQueueSendFromISR(hqueue, pevent, &higher_priority_task_woken));
+  bool ret = post_done_(hao, posted, posted ? uxQueueMessagesWaitingFromISR(hqueue) : 0);
+  portYIELD_FROM_ISR(higher_priority_task_woken);
+  return ret;
+}
+
+void ao_stats(const ao_t* hao, ao_stats_t* pstats)
+{
+  pstats->posted = hao->stats.posted;
+  pstats->post_failed = hao->stats.post_failed;
+  pstats->dispatched = hao->stats.dispatched;
+  pstats->queue_high_water = hao->stats.queue_high_water;
+  pstats->dispatch_last_cycles = hao->stats.dispatch_last_cycles;
+  pstats->dispatch_max_cycles = hao->stats.dispatch_max_cycles;
+  pstats->start_cycles = hao->stats.start_cycles;
+  pstats->stop_cycles = hao->stats.stop_cycles;
+}
+
+/********************** end of file ******************************************/
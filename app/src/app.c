@@ -38,6 +38,8 @@
 #include "cmsis_os.h"
 #include "logger.h"
 #include "dwt.h"
+#include "crash_log.h"
+#include "journal.h"
 #include "board.h"
 
 #include "task_button.h"
@@ -59,20 +61,17 @@
 /********************** external functions definition ************************/
 void app_init(void)
 {
+  cycle_counter_init();
+  logger_init();
+  crash_log_init();
+  journal_init();
+
   ao_ui_init();
   ao_led_init();
 
-  BaseType_t status;
-
-  status = xTaskCreate(task_button, "task_button", 128, NULL, 1, NULL);
-  while (pdPASS != status)
-  {
-    // error
-  }
+  task_button_init();
 
   LOGGER_INFO("app init");
-
-  cycle_counter_init();
 }
 
 /********************** end of file ******************************************/
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : button_gesture.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "timers.h"
+#include "crash_log.h"
+
+#include "button_gesture.h"
+
+/********************** macros and definitions *******************************/
+
+/********************** internal data declaration ****************************/
+
+typedef enum
+{
+  STATE_IDLE,
+  STATE_PRESSED,                /* down, short_ms not reached */
+  STATE_HELD_SHORT,             /* SHORT sent, waiting for long_ms */
+  STATE_HELD_LONG,              /* LONG sent, repeating */
+  STATE_GAP,                    /* up after a click, waiting for another one */
+  STATE__N,
+} state_t;
+
+typedef enum
+{
+  INPUT_PRESS,
+  INPUT_RELEASE,
+  INPUT_TIMER,
+  INPUT__N,
+} input_t;
+
+typedef enum
+{
+  ACTION_NONE,
+  ACTION_CLICK,                 /* counts a click, sends it at once if clicks_max is reached */
+  ACTION_SEND_CLICKS,
+  ACTION_SEND_SHORT,            /* pending clicks go first */
+  ACTION_SEND_LONG,
+  ACTION_SEND_REPEAT,
+} action_t;
+
+typedef enum
+{
+  TIMEOUT_KEEP,
+  TIMEOUT_STOP,
+  TIMEOUT_SHORT,
+  TIMEOUT_LONG,
+  TIMEOUT_REPEAT,
+  TIMEOUT_GAP,
+} timeout_t;
+
+typedef struct
+{
+    uint8_t next;               /* state_t */
+    uint8_t action;             /* action_t */
+    uint8_t timeout;            /* timeout_t */
+} transition_t;
+
+typedef struct
+{
+    button_gesture_config_t config;
+    state_t state;
+    uint8_t clicks;
+    bool armed;
+    TickType_t expiry;
+    TimerHandle_t htimer;
+    StaticTimer_t timer_buffer;
+} button_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+static const transition_t table_[STATE__N][INPUT__N] = {
+  [STATE_IDLE] = {
+    [INPUT_PRESS]   = {STATE_PRESSED,    ACTION_NONE,        TIMEOUT_SHORT},
+    [INPUT_RELEASE] = {STATE_IDLE,       ACTION_NONE,        TIMEOUT_STOP},
+    [INPUT_TIMER]   = {STATE_IDLE,       ACTION_NONE,        TIMEOUT_STOP},
+  },
+  [STATE_PRESSED] = {
+    [INPUT_PRESS]   = {STATE_PRESSED,    ACTION_NONE,        TIMEOUT_KEEP},
+    [INPUT_RELEASE] = {STATE_GAP,        ACTION_CLICK,       TIMEOUT_GAP},
+    [INPUT_TIMER]   = {STATE_HELD_SHORT, ACTION_SEND_SHORT,  TIMEOUT_LONG},
+  },
+  [STATE_HELD_SHORT] = {
+    [INPUT_PRESS]   = {STATE_HELD_SHORT, ACTION_NONE,        TIMEOUT_KEEP},
+    [INPUT_RELEASE] = {STATE_IDLE,       ACTION_NONE,        TIMEOUT_STOP},
+    [INPUT_TIMER]   = {STATE_HELD_LONG,  ACTION_SEND_LONG,   TIMEOUT_REPEAT},
+  },
+  [STATE_HELD_LONG] = {
+    [INPUT_PRESS]   = {STATE_HELD_LONG,  ACTION_NONE,        TIMEOUT_KEEP},
+    [INPUT_RELEASE] = {STATE_IDLE,       ACTION_NONE,        TIMEOUT_STOP},
+    [INPUT_TIMER]   = {STATE_HELD_LONG,  ACTION_SEND_REPEAT, TIMEOUT_REPEAT},
+  },
+  [STATE_GAP] = {
+    [INPUT_PRESS]   = {STATE_PRESSED,    ACTION_NONE,        TIMEOUT_SHORT},
+    [INPUT_RELEASE] = {STATE_GAP,        ACTION_NONE,        TIMEOUT_KEEP},
+    [INPUT_TIMER]   = {STATE_IDLE,       ACTION_SEND_CLICKS, TIMEOUT_STOP},
+  },
+};
+
+static button_t buttons_[BUTTON_GESTURE_BUTTONS_MAX];
+static button_gesture_cb_t callback_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/*
+ * Runs in the timer task, so it cannot wait for room in the timer queue. If
+ * the command does not fit, the gesture in progress is dropped: the button
+ * goes back to idle and the next press starts over.
+ */
+static void timer_arm_(button_t* pbutton, timeout_t timeout)
+{
+  uint16_t ms = 0;
+  switch (timeout) {
+    case TIMEOUT_KEEP:
+      return;
+    case TIMEOUT_SHORT:
+      ms = pbutton->config.short_ms;
+      break;
+    case TIMEOUT_LONG:
+      ms = pbutton->config.long_ms - pbutton->config.short_ms;
+      break;
+    case TIMEOUT_REPEAT:
+      ms = pbutton->config.repeat_ms;
+      break;
+    case TIMEOUT_GAP:
+      ms = pbutton->config.gap_ms;
+      break;
+    case TIMEOUT_STOP:
+    default:
+      break;
+  }
+
+  BaseType_t status;
+  if(0 == ms)
+  {
+    pbutton->armed = false;
+    status = xTimerStop(pbutton->htimer, 0);
+  }
+  else
+  {
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+    if(0 == ticks)
+    {
+      ticks = 1;
+    }
+    pbutton->armed = true;
+    pbutton->expiry = xTaskGetTickCount() + ticks;
+    status = xTimerChangePeriod(pbutton->htimer, ticks, 0);
+  }
+
+  if(pdPASS != status)
+  {
+    // a timer still running expires with armed false and is ignored
+    pbutton->armed = false;
+    pbutton->state = STATE_IDLE;
+    pbutton->clicks = 0;
+  }
+}
+
+static void send_clicks_(uint8_t button, button_t* pbutton)
+{
+  if(0 < pbutton->clicks)
+  {
+    callback_(button, (button_gesture_t)(BUTTON_GESTURE_CLICK + pbutton->clicks - 1));
+    pbutton->clicks = 0;
+  }
+}
+
+static void input_(uint8_t button, input_t input)
+{
+  button_t* pbutton = &buttons_[button];
+  const transition_t* ptransition = &table_[pbutton->state][input];
+  state_t next = (state_t)ptransition->next;
+  timeout_t timeout = (timeout_t)ptransition->timeout;
+
+  switch ((action_t)ptransition->action) {
+    case ACTION_CLICK:
+      pbutton->clicks++;
+      if(pbutton->config.clicks_max <= pbutton->clicks)
+      {
+        send_clicks_(button, pbutton);
+        next = STATE_IDLE;
+        timeout = TIMEOUT_STOP;
+      }
+      break;
+    case ACTION_SEND_CLICKS:
+      send_clicks_(button, pbutton);
+      break;
+    case ACTION_SEND_SHORT:
+      send_clicks_(button, pbutton);
+      callback_(button, BUTTON_GESTURE_SHORT);
+      break;
+    case ACTION_SEND_LONG:
+      callback_(button, BUTTON_GESTURE_LONG);
+      break;
+    case ACTION_SEND_REPEAT:
+      callback_(button, BUTTON_GESTURE_REPEAT);
+      break;
+    case ACTION_NONE:
+    default:
+      break;
+  }
+
+  pbutton->state = next;
+  timer_arm_(pbutton, timeout);
+}
+
+static void timer_callback_(TimerHandle_t htimer)
+{
+  uint8_t button = (uint8_t)(uintptr_t)pvTimerGetTimerID(htimer);
+  button_t* pbutton = &buttons_[button];
+
+  // una expiracion anterior a un rearme o a un stop que todavia no se proceso
+  if(!pbutton->armed || ((TickType_t)(xTaskGetTickCount() - pbutton->expiry) > (portMAX_DELAY / 2)))
+  {
+    return;
+  }
+  pbutton->armed = false;
+  input_(button, INPUT_TIMER);
+}
+
+/********************** external functions definition ************************/
+
+void button_gesture_init(button_gesture_cb_t callback)
+{
+  if(NULL == callback)
+  {
+    crash_log_panic("button_gesture_init");
+  }
+  callback_ = callback;
+
+  for(size_t i = 0; i < BUTTON_GESTURE_BUTTONS_MAX; i++)
+  {
+    button_t* pbutton = &buttons_[i];
+    pbutton->config = (button_gesture_config_t)BUTTON_GESTURE_CONFIG_DEFAULT;
+    pbutton->state = STATE_IDLE;
+    pbutton->clicks = 0;
+    pbutton->armed = false;
+    pbutton->htimer = xTimerCreateStatic("gesture", 1, pdFALSE, (void*)(uintptr_t)i, timer_callback_, &pbutton->timer_buffer);
+    if(NULL == pbutton->htimer)
+    {
+      crash_log_panic("button_gesture_init xTimerCreateStatic");
+    }
+  }
+}
+
+bool button_gesture_config_set(uint8_t button, const button_gesture_config_t* pconfig)
+{
+  if((BUTTON_GESTURE_BUTTONS_MAX <= button) || (pconfig->long_ms <= pconfig->short_ms)
+      || (0 == pconfig->short_ms) || (0 == pconfig->clicks_max) || (BUTTON_GESTURE_CLICKS_MAX < pconfig->clicks_max))
+  {
+    return false;
+  }
+  taskENTER_CRITICAL();
+  buttons_[button].config = *pconfig;
+  taskEXIT_CRITICAL();
+  return true;
+}
+
+void button_gesture_config_get(uint8_t button, button_gesture_config_t* pconfig)
+{
+  taskENTER_CRITICAL();
+  *pconfig = buttons_[button].config;
+  taskEXIT_CRITICAL();
+}
+
+void button_gesture_input(uint8_t button, button_scan_event_t event)
+{
+  if(BUTTON_GESTURE_BUTTONS_MAX <= button)
+  {
+    return;
+  }
+  switch (event) {
+    case BUTTON_SCAN_EVENT_PRESS:
+      input_(button, INPUT_PRESS);
+      break;
+    case BUTTON_SCAN_EVENT_RELEASE:
+      input_(button, INPUT_RELEASE);
+      break;
+    default:
+      break;
+  }
+}
+
+/********************** end of file ******************************************/
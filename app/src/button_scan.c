@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : button_scan.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "timers.h"
+#include "dwt.h"
+#include "crash_log.h"
+
+#include "button_scan.h"
+
+/********************** macros and definitions *******************************/
+
+#define PINS_PER_PORT_          (16)
+
+/********************** internal data declaration ****************************/
+
+typedef struct
+{
+    GPIO_TypeDef* hport;
+    uint32_t mask;                          /* pins scanned */
+    uint32_t invert;                        /* pins pressed when low */
+    uint32_t state;                         /* debounced, bit set: pressed */
+    uint32_t cnt0;                          /* vertical counter, bit 0 */
+    uint32_t cnt1;                          /* vertical counter, bit 1 */
+    uint32_t held;                          /* HOLD already sent for this press */
+    uint8_t id[PINS_PER_PORT_];
+    uint32_t press_cycles[PINS_PER_PORT_];
+} port_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+static port_t ports_[BUTTON_SCAN_PORTS_MAX];
+static size_t nports_;
+static uint8_t nbuttons_;
+static button_scan_cb_t callback_;
+static TimerHandle_t htimer_;
+static StaticTimer_t timer_buffer_;
+static volatile bool running_;
+
+/* EXTI line n: first edge not yet consumed by the scanner */
+static volatile uint32_t edge_pending_;
+static uint32_t edge_cycles_[PINS_PER_PORT_];
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/* stamp of the first edge on line since the last change, else now */
+static uint32_t edge_take_(uint32_t bit, uint32_t line, uint32_t now)
+{
+  uint32_t cycles = now;
+  taskENTER_CRITICAL();
+  if(0 != (edge_pending_ & bit))
+  {
+    cycles = edge_cycles_[line];
+    edge_pending_ &= ~bit;
+  }
+  taskEXIT_CRITICAL();
+  return cycles;
+}
+
+/* lines back at their debounced level: the edges were bounces */
+static void edge_forget_(uint32_t mask)
+{
+  taskENTER_CRITICAL();
+  edge_pending_ &= ~mask;
+  taskEXIT_CRITICAL();
+}
+
+static uint32_t port_sample_(const port_t* pport)
+{
+  return (pport->hport->IDR ^ pport->invert) & pport->mask;
+}
+
+/* one pass over a whole port, returns true while some pin is pressed or changing */
+static bool port_scan_(port_t* pport, uint32_t now)
+{
+  uint32_t delta = port_sample_(pport) ^ pport->state;
+  pport->cnt1 = (pport->cnt1 ^ pport->cnt0) & delta;
+  pport->cnt0 = ~pport->cnt0 & delta;
+  uint32_t toggle = delta & ~(pport->cnt0 | pport->cnt1);
+  pport->state ^= toggle;
+
+  edge_forget_(pport->mask & ~delta);
+
+  while(0 != toggle)
+  {
+    uint32_t line = 31 - __CLZ(toggle);
+    uint32_t bit = 1UL << line;
+    toggle &= ~bit;
+
+    uint32_t cycles = edge_take_(bit, line, now);
+    if(0 != (pport->state & bit))
+    {
+      pport->press_cycles[line] = cycles;
+      pport->held &= ~bit;
+      callback_(pport->id[line], BUTTON_SCAN_EVENT_PRESS, cycles);
+    }
+    else
+    {
+      callback_(pport->id[line], BUTTON_SCAN_EVENT_RELEASE, cycles);
+    }
+  }
+
+  uint32_t holding = pport->state & ~pport->held;
+  while(0 != holding)
+  {
+    uint32_t line = 31 - __CLZ(holding);
+    uint32_t bit = 1UL << line;
+    holding &= ~bit;
+
+    if(((now - pport->press_cycles[line]) / cycles_per_us) >= (BUTTON_SCAN_HOLD_MS * 1000UL))
+    {
+      pport->held |= bit;
+      callback_(pport->id[line], BUTTON_SCAN_EVENT_HOLD, now);
+    }
+  }
+
+  return (0 != pport->state) || (0 != delta);
+}
+
+/* one-shot, re-armed while there is activity; idle it waits for an EXTI edge */
+static void timer_callback_(TimerHandle_t htimer)
+{
+  uint32_t now = cycle_counter_get();
+  bool active = false;
+  for(size_t i = 0; i < nports_; i++)
+  {
+    active |= port_scan_(&ports_[i], now);
+  }
+
+  taskENTER_CRITICAL();
+  if(!active && (0 == edge_pending_))
+  {
+    running_ = false;
+  }
+  taskEXIT_CRITICAL();
+
+  /* timer queue full: stop, the next EXTI edge starts the scan again */
+  if(running_ && (pdPASS != xTimerReset(htimer, 0)))
+  {
+    running_ = false;
+  }
+}
+
+/********************** external functions definition ************************/
+
+void button_scan_init(button_scan_cb_t callback)
+{
+  callback_ = callback;
+  nports_ = 0;
+  nbuttons_ = 0;
+  running_ = false;
+  edge_pending_ = 0;
+  htimer_ = xTimerCreateStatic("button_scan", pdMS_TO_TICKS(BUTTON_SCAN_PERIOD_MS), pdFALSE, NULL, timer_callback_, &timer_buffer_);
+  if((NULL == callback) || (NULL == htimer_))
+  {
+    crash_log_panic("button_scan_init");
+  }
+}
+
+uint8_t button_scan_add(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState pressed)
+{
+  size_t i = 0;
+  while((i < nports_) && (ports_[i].hport != port))
+  {
+    i++;
+  }
+  if(i == nports_)
+  {
+    if(BUTTON_SCAN_PORTS_MAX <= nports_)
+    {
+      crash_log_panic("button_scan_add ports");
+    }
+    ports_[nports_++] = (port_t){.hport = port};
+  }
+
+  port_t* pport = &ports_[i];
+  uint32_t line = 31 - __CLZ(pin);
+  if(0 != (pport->mask & pin))
+  {
+    return pport->id[line];
+  }
+  if(BUTTON_SCAN_BUTTONS_MAX <= nbuttons_)
+  {
+    crash_log_panic("button_scan_add buttons");
+  }
+
+  pport->mask |= pin;
+  if(GPIO_PIN_RESET == pressed)
+  {
+    pport->invert |= pin;
+  }
+  pport->id[line] = nbuttons_;
+  return nbuttons_++;
+}
+
+void button_scan_start(void)
+{
+  bool active = false;
+  uint32_t now = cycle_counter_get();
+  for(size_t i = 0; i < nports_; i++)
+  {
+    port_t* pport = &ports_[i];
+    pport->state = port_sample_(pport);
+    for(uint32_t line = 0; line < PINS_PER_PORT_; line++)
+    {
+      pport->press_cycles[line] = now;
+    }
+    active |= (0 != pport->state);
+  }
+
+  if(active)
+  {
+    running_ = (pdPASS == xTimerStart(htimer_, 0));
+  }
+}
+
+void button_scan_edge_from_isr(uint16_t pin)
+{
+  uint32_t cycles = cycle_counter_get();
+  uint32_t line = 31 - __CLZ(pin);
+  if(0 == (edge_pending_ & pin))
+  {
+    edge_cycles_[line] = cycles;
+    edge_pending_ |= pin;
+  }
+
+  if(!running_)
+  {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    /* left stopped if the timer queue is full, the next edge tries again */
+    running_ = (pdPASS == xTimerStartFromISR(htimer_, &higher_priority_task_woken));
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+  }
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : crash_log.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "logger.h"
+#include "crash_log.h"
+
+/********************** macros and definitions *******************************/
+
+#define MAGIC_                    (0xC0DEDEADu)
+#define HISTORY_MASK_             (CRASH_LOG_CONFIG_HISTORY_LEN - 1)
+#define FRAME_WORDS_              (8)
+#define EXC_RETURN_FPU_FRAME_     (1u << 4)
+#define FRAME_FPU_WORDS_          (18)
+
+#if 0 != (CRASH_LOG_CONFIG_HISTORY_LEN & HISTORY_MASK_)
+#error "CRASH_LOG_CONFIG_HISTORY_LEN must be a power of two"
+#endif
+
+/********************** internal data declaration ****************************/
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t build_id;
+  uint32_t reason;
+  const char* what;
+  uint32_t context;
+  uint32_t r0;
+  uint32_t r1;
+  uint32_t r2;
+  uint32_t r3;
+  uint32_t r12;
+  uint32_t lr;
+  uint32_t pc;
+  uint32_t xpsr;
+  uint32_t sp;
+  uint32_t exc_return;
+  uint32_t cfsr;
+  uint32_t hfsr;
+  uint32_t mmfar;
+  uint32_t bfar;
+  uint32_t stack_len;
+  uint32_t stack[CRASH_LOG_CONFIG_STACK_WORDS];
+  uint32_t history_head;
+  logger_record_t history[CRASH_LOG_CONFIG_HISTORY_LEN];
+} crash_log_t;
+
+/********************** internal functions declaration ***********************/
+
+void crash_log_fault_(uint32_t* pframe, uint32_t exc_return) __attribute__((used, noreturn));
+
+/********************** internal data definition *****************************/
+
+/* not zeroed by the startup code, survives a reset while powered */
+static crash_log_t crash_log_ __attribute__((section(".noinit")));
+
+/********************** external data definition *****************************/
+
+extern uint32_t _estack;
+extern const char _build_id_start[];
+
+#if 1 == LOGGER_CONFIG_USE_TOKENS
+/* absolute linker symbol, its address is the size of .logger_fmt */
+extern const char _logger_fmt_size[];
+#endif
+
+/********************** internal functions definition ************************/
+
+/*
+ * The pointers in the area only make sense for the image that wrote them.
+ * The linker's GNU build id note (-Wl,--build-id) changes with any byte of
+ * the image; its hash descriptor is folded into one word.
+ */
+static uint32_t build_id_(void)
+{
+  const uint32_t* pnote = (const uint32_t*)_build_id_start;
+  uint32_t namesz = pnote[0];
+  uint32_t descsz = pnote[1];
+  const uint8_t* p = (const uint8_t*)&pnote[3] + ((namesz + 3u) & ~3u);
+  uint32_t hash = 2166136261u;
+  for(uint32_t i = 0; i < descsz; ++i)
+  {
+    hash = (hash ^ p[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static bool readable_(const void* p, uint32_t len)
+{
+  uint32_t addr = (uint32_t)(uintptr_t)p;
+  if((FLASH_BASE <= addr) && (addr + len <= FLASH_END + 1))
+  {
+    return true;
+  }
+  return (SRAM1_BASE <= addr) && (addr + len <= (uint32_t)(uintptr_t)&_estack);
+}
+
+/*
+ * In tokenized mode fmt is not a pointer but an offset into .logger_fmt,
+ * which is not loaded to the target, so it is checked against the section
+ * size instead. Token 0 is a reserved byte, like NULL for an empty slot.
+ */
+static bool fmt_valid_(const char* fmt)
+{
+  if(NULL == fmt)
+  {
+    return false;
+  }
+#if 1 == LOGGER_CONFIG_USE_TOKENS
+  return (uintptr_t)fmt < (uintptr_t)_logger_fmt_size;
+#else
+  return readable_(fmt, 1);
+#endif
+}
+
+/* records still queued in the logger were never printed, keep them too */
+static void history_flush_(void)
+{
+  logger_pending_foreach(crash_log_record);
+}
+
+static void reset_(void) __attribute__((noreturn));
+static void reset_(void)
+{
+  crash_log_.magic = MAGIC_;
+  __DSB();
+  NVIC_SystemReset();
+  while(true)
+  {
+    // wait for the reset
+  }
+}
+
+static void report_(void)
+{
+  const char* what = readable_(crash_log_.what, 1) ? crash_log_.what : "";
+  LOGGER_ERROR("crash: reason %lu context %08lx %s", crash_log_.reason, crash_log_.context, what);
+  LOGGER_ERROR("crash: pc %08lx lr %08lx xpsr %08lx sp %08lx", crash_log_.pc, crash_log_.lr, crash_log_.xpsr, crash_log_.sp);
+  LOGGER_ERROR("crash: r0 %08lx r1 %08lx r2 %08lx r3 %08lx", crash_log_.r0, crash_log_.r1, crash_log_.r2, crash_log_.r3);
+  LOGGER_ERROR("crash: r12 %08lx exc_return %08lx cfsr %08lx hfsr %08lx", crash_log_.r12, crash_log_.exc_return, crash_log_.cfsr, crash_log_.hfsr);
+  LOGGER_ERROR("crash: mmfar %08lx bfar %08lx", crash_log_.mmfar, crash_log_.bfar);
+
+  uint32_t stack_len = crash_log_.stack_len;
+  if(CRASH_LOG_CONFIG_STACK_WORDS < stack_len)
+  {
+    stack_len = CRASH_LOG_CONFIG_STACK_WORDS;
+  }
+  for(uint32_t i = 0; i + 4 <= stack_len; i += 4)
+  {
+    LOGGER_ERROR("crash: stack %08lx %08lx %08lx %08lx", crash_log_.stack[i], crash_log_.stack[i + 1], crash_log_.stack[i + 2], crash_log_.stack[i + 3]);
+  }
+
+  /* replayed with their original stamp and context, oldest first */
+  LOGGER_ERROR("crash: last log records");
+  for(uint32_t i = 0; i < CRASH_LOG_CONFIG_HISTORY_LEN; ++i)
+  {
+    const logger_record_t* precord = &crash_log_.history[(crash_log_.history_head + i) & HISTORY_MASK_];
+    if((LOGGER_CONFIG_MAXARGS < precord->nargs) || !fmt_valid_(precord->fmt))
+    {
+      continue;
+    }
+    logger_replay(precord);
+  }
+}
+
+/********************** external functions definition ************************/
+
+void crash_log_init(void)
+{
+  uint32_t build_id = build_id_();
+  if((MAGIC_ == crash_log_.magic) && (build_id == crash_log_.build_id))
+  {
+    report_();
+  }
+
+  memset(&crash_log_, 0, sizeof(crash_log_));
+  crash_log_.build_id = build_id;
+}
+
+/* called only from the logger drain task and from the fault path */
+void crash_log_record(const logger_record_t* precord)
+{
+  crash_log_.history[crash_log_.history_head & HISTORY_MASK_] = *precord;
+  crash_log_.history_head++;
+}
+
+void crash_log_panic(const char* what)
+{
+  __disable_irq();
+  crash_log_.reason = CRASH_LOG_REASON_PANIC;
+  crash_log_.what = what;
+  crash_log_.context = logger_context_get();
+  crash_log_.lr = (uint32_t)(uintptr_t)__builtin_return_address(0);
+  crash_log_.sp = __get_MSP();
+  crash_log_.stack_len = 0;
+  history_flush_();
+  reset_();
+}
+
+/*
+ * Picks the stack the exception frame was pushed to from EXC_RETURN bit 2,
+ * before anything else touches the stack.
+ */
+void crash_log_fault_entry(void)
+{
+  __asm volatile(
+      "tst lr, #4           \n"
+      "ite eq               \n"
+      "mrseq r0, msp        \n"
+      "mrsne r0, psp        \n"
+      "mov r1, lr           \n"
+      "b crash_log_fault_   \n");
+}
+
+/* runs in the fault handler: RAM writes only, no flash, nothing that blocks */
+void crash_log_fault_(uint32_t* pframe, uint32_t exc_return)
+{
+  __disable_irq();
+  crash_log_.reason = __get_IPSR() & 0x1FFu;
+  crash_log_.what = NULL;
+  crash_log_.exc_return = exc_return;
+  crash_log_.cfsr = SCB->CFSR;
+  crash_log_.hfsr = SCB->HFSR;
+  crash_log_.mmfar = SCB->MMFAR;
+  crash_log_.bfar = SCB->BFAR;
+  crash_log_.stack_len = 0;
+
+  /* a stacking fault leaves a bogus frame pointer, don't fault again on it */
+  if(readable_(pframe, FRAME_WORDS_ * sizeof(uint32_t)))
+  {
+    crash_log_.r0 = pframe[0];
+    crash_log_.r1 = pframe[1];
+    crash_log_.r2 = pframe[2];
+    crash_log_.r3 = pframe[3];
+    crash_log_.r12 = pframe[4];
+    crash_log_.lr = pframe[5];
+    crash_log_.pc = pframe[6];
+    crash_log_.xpsr = pframe[7];
+
+    uint32_t* psp = pframe + FRAME_WORDS_;
+    if(0 == (exc_return & EXC_RETURN_FPU_FRAME_))
+    {
+      psp += FRAME_FPU_WORDS_;
+    }
+    crash_log_.sp = (uint32_t)(uintptr_t)psp;
+    while((crash_log_.stack_len < CRASH_LOG_CONFIG_STACK_WORDS) && readable_(psp, sizeof(uint32_t)))
+    {
+      crash_log_.stack[crash_log_.stack_len++] = *psp++;
+    }
+  }
+
+  /* the faulting context, taken from the thread mode side of EXC_RETURN */
+  crash_log_.context = (0 != (exc_return & 4u)) ? (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle() : (crash_log_.xpsr & 0x1FFu);
+  history_flush_();
+  reset_();
+}
+
+/********************** end of file ******************************************/
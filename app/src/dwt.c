@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2023 Juan Manuel Cruz <jcruz@fi.uba.ar>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : dwt.c
+ * @date   : Set 26, 2023
+ * @author : Juan Manuel Cruz <jcruz@fi.uba.ar> <jcruz@frba.utn.edu.ar>
+ * @version	v1.0.0
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+#include "dwt.h"
+#include "atomic_ops.h"
+
+/********************** macros and definitions *******************************/
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/* bits 31..1: high word of the 64-bit count, bit 0: MSB of the last CYCCNT seen */
+static volatile uint32_t cycle_counter_state_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/********************** external functions definition ************************/
+
+/*
+ * Lock-free, callable from any context. A wrap is detected when the MSB of
+ * CYCCNT goes from 1 to 0 between two observations, hence the 2^31 cycle
+ * bound (about 25 s at 84 MHz); the tick hook below guarantees it.
+ */
+uint64_t cycle_counter_get_64(void)
+{
+  uint32_t state;
+  uint32_t next;
+  uint32_t low;
+  uint32_t high;
+  do
+  {
+    state = cycle_counter_state_;
+    low = cycle_counter_get();
+    high = state >> 1;
+    if((0 != (state & 1)) && (0 == (low >> 31)))
+    {
+      high++;
+    }
+    next = (high << 1) | (low >> 31);
+  } while((next != state) && !atomic_ops_cas_u32(&cycle_counter_state_, state, next));
+
+  return ((uint64_t)high << 32) | low;
+}
+
+/* FreeRTOS tick hook (configUSE_TICK_HOOK): one observation per tick, whatever the load */
+void vApplicationTickHook(void)
+{
+  (void)cycle_counter_get_64();
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : id_index.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "id_index.h"
+
+/********************** macros and definitions *******************************/
+
+#define HASH_MULTIPLIER_          (2654435769u)   /* 2^32 / golden ratio */
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/* Fibonacci hashing, sequential ids land far apart */
+static uint32_t slot_(const id_index_t* hindex, uint32_t id)
+{
+  return (id * HASH_MULTIPLIER_) >> hindex->shift;
+}
+
+/* the slot holding id, or the empty slot that ends its probe sequence */
+static uint32_t probe_(const id_index_t* hindex, uint32_t id)
+{
+  uint32_t i = slot_(hindex, id);
+  while((NULL != hindex->pentry[i].pvalue) && (id != hindex->pentry[i].id))
+  {
+    i = (i + 1) & hindex->mask;
+  }
+  return i;
+}
+
+/********************** external functions definition ************************/
+
+bool id_index_init(id_index_t* hindex, id_index_entry_t* pstorage, size_t capacity)
+{
+  if((2 > capacity) || (0 != (capacity & (capacity - 1))))
+  {
+    return false;
+  }
+
+  uint32_t bits = 0;
+  while(((size_t)1 << bits) < capacity)
+  {
+    bits++;
+  }
+
+  hindex->pentry = pstorage;
+  hindex->mask = capacity - 1;
+  hindex->shift = 32 - bits;
+  hindex->count = 0;
+  for(size_t i = 0; i < capacity; ++i)
+  {
+    pstorage[i].pvalue = NULL;
+  }
+  return true;
+}
+
+bool id_index_insert(id_index_t* hindex, uint32_t id, void* pvalue)
+{
+  uint32_t i = probe_(hindex, id);
+  id_index_entry_t* pentry = &hindex->pentry[i];
+  if(NULL == pentry->pvalue)
+  {
+    /* one slot always stays empty so every probe ends */
+    if(hindex->mask <= hindex->count)
+    {
+      return false;
+    }
+    hindex->count++;
+  }
+  pentry->id = id;
+  pentry->pvalue = pvalue;
+  return true;
+}
+
+void* id_index_find(const id_index_t* hindex, uint32_t id)
+{
+  return hindex->pentry[probe_(hindex, id)].pvalue;
+}
+
+/*
+ * Backward shift: the entries after the hole that would no longer be reached
+ * from their home slot are moved into it, so lookups never need tombstones.
+ */
+void* id_index_remove(id_index_t* hindex, uint32_t id)
+{
+  uint32_t hole = probe_(hindex, id);
+  void* pvalue = hindex->pentry[hole].pvalue;
+  if(NULL == pvalue)
+  {
+    return NULL;
+  }
+
+  uint32_t i = hole;
+  while(true)
+  {
+    i = (i + 1) & hindex->mask;
+    id_index_entry_t* pentry = &hindex->pentry[i];
+    if(NULL == pentry->pvalue)
+    {
+      break;
+    }
+    uint32_t home = slot_(hindex, pentry->id);
+    /* move it unless its home lies cyclically in (hole, i] */
+    if(((i - home) & hindex->mask) >= ((i - hole) & hindex->mask))
+    {
+      hindex->pentry[hole] = *pentry;
+      hole = i;
+    }
+  }
+  hindex->pentry[hole].pvalue = NULL;
+  hindex->count--;
+  return pvalue;
+}
+
+uint32_t id_index_count(const id_index_t* hindex)
+{
+  return hindex->count;
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : journal.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "logger.h"
+#include "atomic_ops.h"
+#include "dwt.h"
+#include "crash_log.h"
+#include "journal.h"
+
+/********************** macros and definitions *******************************/
+
+#define MAGIC_                    (0x4C4E524Au)   /* "JRNL" */
+#define ERASED_                   (0xFFFFFFFFu)
+#define UNSET_                    (0x80u)         /* event flag: snapshot of an event never written */
+
+#define SECTORS_                  (2)
+#define SECTOR_SIZE_              (16 * 1024)
+#define SECTOR_FIRST_             (FLASH_SECTOR_1)
+#define SECTOR_NONE_              (SECTORS_)
+#define SECTOR_RECORDS_           ((SECTOR_SIZE_ - sizeof(journal_header_t)) / sizeof(journal_record_t))
+
+/********************** internal data declaration ****************************/
+
+/*
+ * Sector layout: header, then 8 byte records appended in order. The tick word
+ * is programmed first and the event word last, so a record cut by a reset
+ * fails the check and is skipped, while the slot still counts as used.
+ */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t generation;
+} journal_header_t;
+
+typedef struct
+{
+  uint32_t tick;
+  uint8_t event;
+  uint8_t value;
+  uint16_t check;
+} journal_record_t;
+
+typedef struct
+{
+  uint8_t event;
+  uint8_t value;
+} journal_msg_t;
+
+_Static_assert(JOURNAL_EVENT__N <= UNSET_, "journal events collide with the UNSET_ flag");
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+static struct
+{
+  QueueHandle_t hqueue;
+  volatile uint32_t dropped;
+  uint32_t sector;
+  uint32_t generation;
+  uint32_t next;
+  uint32_t since_snapshot;
+  bool spare_erased;              /* the sector the next switch uses is blank */
+  volatile uint32_t valid;
+  volatile uint8_t last[JOURNAL_EVENT__N];
+} journal_;
+
+/********************** external data definition *****************************/
+
+extern uint32_t _sjournal;
+
+/********************** internal functions definition ************************/
+
+static const journal_header_t* header_(uint32_t sector)
+{
+  return (const journal_header_t*)((uintptr_t)&_sjournal + sector * SECTOR_SIZE_);
+}
+
+static const journal_record_t* record_(uint32_t sector, uint32_t index)
+{
+  return (const journal_record_t*)(header_(sector) + 1) + index;
+}
+
+static uint16_t check_(uint32_t tick, uint8_t event, uint8_t value)
+{
+  return (uint16_t)~((uint16_t)(event | (value << 8)) ^ (uint16_t)tick ^ (uint16_t)(tick >> 16));
+}
+
+static bool slot_used_(const journal_record_t* precord)
+{
+  const volatile uint32_t* pword = (const volatile uint32_t*)precord;
+  return (ERASED_ != pword[0]) || (ERASED_ != pword[1]);
+}
+
+static bool record_valid_(const journal_record_t* precord)
+{
+  return ((precord->event & ~UNSET_) < JOURNAL_EVENT__N) && (check_(precord->tick, precord->event, precord->value) == precord->check);
+}
+
+static void last_set_(uint8_t event, uint8_t value)
+{
+  journal_.last[event] = value;
+  journal_.valid |= (1u << event);
+}
+
+/* records are appended in order, so used slots are a prefix of the sector */
+static uint32_t end_find_(uint32_t sector)
+{
+  uint32_t lo = 0;
+  uint32_t hi = SECTOR_RECORDS_;
+  while(lo < hi)
+  {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if(slot_used_(record_(sector, mid)))
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/*
+ * A snapshot holds every event, written or not (UNSET_), and is never more
+ * than JOURNAL_CONFIG_SNAPSHOT_PERIOD records back: the scan stops there.
+ */
+static void last_scan_(uint32_t sector, uint32_t end)
+{
+  const uint32_t all = (1u << JOURNAL_EVENT__N) - 1;
+  uint32_t found = 0;
+  uint32_t i = end;
+  while((0 < i) && (all != found))
+  {
+    const journal_record_t* precord = record_(sector, --i);
+    if(!record_valid_(precord))
+    {
+      continue;
+    }
+    uint8_t event = precord->event & ~UNSET_;
+    if(0 == (found & (1u << event)))
+    {
+      found |= (1u << event);
+      if(0 == (precord->event & UNSET_))
+      {
+        last_set_(event, precord->value);
+      }
+    }
+  }
+}
+
+static uint32_t sector_next_(void)
+{
+  return (SECTOR_NONE_ == journal_.sector) ? 0 : (journal_.sector + 1) % SECTORS_;
+}
+
+static bool sector_blank_(uint32_t sector)
+{
+  const volatile uint32_t* pword = (const volatile uint32_t*)header_(sector);
+  for(uint32_t i = 0; i < (SECTOR_SIZE_ / sizeof(uint32_t)); ++i)
+  {
+    if(ERASED_ != pword[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* stalls the whole CPU until done, see journal.h */
+static bool sector_erase_(uint32_t sector)
+{
+  FLASH_EraseInitTypeDef erase = {
+      .TypeErase = FLASH_TYPEERASE_SECTORS,
+      .Banks = FLASH_BANK_1,
+      .Sector = SECTOR_FIRST_ + sector,
+      .NbSectors = 1,
+      .VoltageRange = FLASH_VOLTAGE_RANGE_3,
+  };
+  uint32_t sector_error;
+  return HAL_OK == HAL_FLASHEx_Erase(&erase, &sector_error);
+}
+
+static void spare_erase_(void)
+{
+  uint32_t cycles = cycle_counter_get();
+  journal_.spare_erased = sector_erase_(sector_next_());
+  cycles = cycle_counter_get() - cycles;
+  LOGGER_INFO("journal: spare sector erased in %lu cycles", cycles);
+}
+
+static bool program_(uint32_t addr, uint32_t data)
+{
+  return HAL_OK == HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, data);
+}
+
+static bool record_program_(uint8_t event, uint8_t value)
+{
+  uint32_t tick = (uint32_t)xTaskGetTickCount();
+  uint32_t addr = (uint32_t)(uintptr_t)record_(journal_.sector, journal_.next);
+  uint32_t word = event | (value << 8) | ((uint32_t)check_(tick, event, value) << 16);
+
+  /* the slot is consumed even if programming fails */
+  journal_.next++;
+  journal_.since_snapshot++;
+  return program_(addr, tick) && program_(addr + 4, word);
+}
+
+static void snapshot_(void)
+{
+  journal_.since_snapshot = 0;
+  for(uint8_t event = 0; event < JOURNAL_EVENT__N; ++event)
+  {
+    if(0 != (journal_.valid & (1u << event)))
+    {
+      record_program_(event, journal_.last[event]);
+    }
+    else
+    {
+      record_program_(event | UNSET_, 0);
+    }
+  }
+}
+
+/*
+ * Wear leveling: the sectors are used round robin, the newest generation is
+ * the active one. The old sector stays valid until the new magic is written,
+ * after the snapshot, so a reset mid switch boots from the old one. The spare
+ * one is normally erased beforehand by the task.
+ */
+static bool sector_switch_(void)
+{
+  uint32_t sector = sector_next_();
+  if(!journal_.spare_erased)
+  {
+    LOGGER_WARN("journal: no idle time to erase the spare sector, erasing inline");
+    if(!sector_erase_(sector))
+    {
+      return false;
+    }
+  }
+  journal_.spare_erased = false;
+
+  /* the snapshot goes in first, the magic word is the last write and commits the switch */
+  uint32_t sector_old = journal_.sector;
+  uint32_t next_old = journal_.next;
+  uint32_t since_old = journal_.since_snapshot;
+  journal_.sector = sector;
+  journal_.next = 0;
+  snapshot_();
+
+  uint32_t addr = (uint32_t)(uintptr_t)header_(sector);
+  if(!program_(addr + 4, journal_.generation + 1) || !program_(addr, MAGIC_))
+  {
+    /* the new sector has no magic, boot ignores it and the next idle time erases it */
+    journal_.sector = sector_old;
+    journal_.next = next_old;
+    journal_.since_snapshot = since_old;
+    return false;
+  }
+
+  journal_.generation++;
+  /* the old sector is now the spare one, erased at the next idle time */
+  return true;
+}
+
+static void record_write_(uint8_t event, uint8_t value)
+{
+  if((SECTOR_NONE_ == journal_.sector) || (SECTOR_RECORDS_ <= journal_.next + JOURNAL_EVENT__N))
+  {
+    if(!sector_switch_())
+    {
+      last_set_(event, value);
+      atomic_ops_add_u32(&journal_.dropped, 1);
+      return;
+    }
+  }
+  else if(JOURNAL_CONFIG_SNAPSHOT_PERIOD <= journal_.since_snapshot)
+  {
+    snapshot_();
+  }
+
+  last_set_(event, value);
+  if(!record_program_(event, value))
+  {
+    atomic_ops_add_u32(&journal_.dropped, 1);
+  }
+}
+
+/*
+ * Flash programming stalls instruction fetch from the same bank, so the
+ * writes are batched here, at idle priority, away from the active objects.
+ */
+static void task_(void *argument)
+{
+  (void)argument;
+  journal_msg_t msg;
+  while(true)
+  {
+    TickType_t wait = journal_.spare_erased ? portMAX_DELAY : (TickType_t)(JOURNAL_CONFIG_IDLE_MS / portTICK_PERIOD_MS);
+    if(pdPASS != xQueueReceive(journal_.hqueue, &msg, wait))
+    {
+      /* no event for a while, the user is not interacting: erase now */
+      HAL_FLASH_Unlock();
+      spare_erase_();
+      HAL_FLASH_Lock();
+    }
+    else
+    {
+      vTaskDelay((TickType_t)(JOURNAL_CONFIG_BATCH_MS / portTICK_PERIOD_MS));
+      HAL_FLASH_Unlock();
+      do
+      {
+        record_write_(msg.event, msg.value);
+      } while(pdPASS == xQueueReceive(journal_.hqueue, &msg, 0));
+      HAL_FLASH_Lock();
+    }
+  }
+}
+
+/********************** external functions definition ************************/
+
+void journal_init(void)
+{
+  uint32_t cycles = cycle_counter_get();
+
+  journal_.dropped = 0;
+  journal_.valid = 0;
+  journal_.sector = SECTOR_NONE_;
+  journal_.generation = 0;
+  for(uint32_t sector = 0; sector < SECTORS_; ++sector)
+  {
+    const journal_header_t* pheader = header_(sector);
+    if((MAGIC_ == pheader->magic) && (ERASED_ != pheader->generation) &&
+       ((SECTOR_NONE_ == journal_.sector) || (journal_.generation < pheader->generation)))
+    {
+      journal_.sector = sector;
+      journal_.generation = pheader->generation;
+    }
+  }
+
+  journal_.next = 0;
+  if(SECTOR_NONE_ != journal_.sector)
+  {
+    journal_.next = end_find_(journal_.sector);
+    last_scan_(journal_.sector, journal_.next);
+  }
+  journal_.spare_erased = sector_blank_(sector_next_());
+  /* start the new boot with a snapshot, the scan is bounded from here */
+  journal_.since_snapshot = JOURNAL_CONFIG_SNAPSHOT_PERIOD;
+
+  cycles = cycle_counter_get() - cycles;
+  LOGGER_INFO("journal: sector %lu record %lu restored in %lu cycles", journal_.sector, journal_.next, cycles);
+
+  journal_.hqueue = xQueueCreate(JOURNAL_CONFIG_QUEUE_LEN, sizeof(journal_msg_t));
+  if(NULL == journal_.hqueue)
+  {
+    crash_log_panic("journal_init xQueueCreate");
+  }
+
+  BaseType_t status;
+  status = xTaskCreate(task_, "task_journal", JOURNAL_CONFIG_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL);
+  if(pdPASS != status)
+  {
+    crash_log_panic("journal_init xTaskCreate");
+  }
+}
+
+bool journal_append(journal_event_t event, uint8_t value)
+{
+  journal_msg_t msg = {.event = (uint8_t)event, .value = value};
+  if(pdPASS != xQueueSend(journal_.hqueue, &msg, 0))
+  {
+    atomic_ops_add_u32(&journal_.dropped, 1);
+    return false;
+  }
+  return true;
+}
+
+bool journal_last(journal_event_t event, uint8_t* pvalue)
+{
+  if(0 == (journal_.valid & (1u << event)))
+  {
+    return false;
+  }
+  *pvalue = journal_.last[event];
+  return true;
+}
+
+uint32_t journal_dropped(void)
+{
+  return journal_.dropped;
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : led_pwm.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+#include "board.h"
+
+#include "led_pwm.h"
+
+#if defined(LED_PWM_PIN)
+
+/********************** macros and definitions *******************************/
+
+#define TIMER_                  TIM8
+#define TIMER_AF_               GPIO_AF3_TIM8
+#define TIMER_TICK_HZ_          (1000000)
+
+/* TIM8_UP request: DMA2 stream 1 channel 7 */
+#define DMA_STREAM_             DMA2_Stream1
+#define DMA_CHANNEL_            (7u)
+#define DMA_IFCR_               (DMA2->LIFCR)
+#define DMA_IFCR_ALL_           (DMA_LIFCR_CFEIF1 | DMA_LIFCR_CDMEIF1 | DMA_LIFCR_CTEIF1 | DMA_LIFCR_CHTIF1 | DMA_LIFCR_CTCIF1)
+
+#define REPETITION_MAX_         (256)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/* compare value for each level: round(LED_PWM_PERIOD * (level / 255) ^ 2.2) */
+static const uint16_t gamma_[] = {
+     0,    0,    0,    0,    0,    0,    0,    0,    0,    1,    1,    1,    1,    1,    2,    2,
+     2,    3,    3,    3,    4,    4,    5,    5,    6,    6,    7,    7,    8,    8,    9,   10,
+    10,   11,   12,   13,   13,   14,   15,   16,   17,   18,   19,   20,   21,   22,   23,   24,
+    25,   27,   28,   29,   30,   32,   33,   34,   36,   37,   38,   40,   41,   43,   45,   46,
+    48,   49,   51,   53,   55,   56,   58,   60,   62,   64,   66,   68,   70,   72,   74,   76,
+    78,   80,   82,   85,   87,   89,   92,   94,   96,   99,  101,  104,  106,  109,  111,  114,
+   117,  119,  122,  125,  128,  130,  133,  136,  139,  142,  145,  148,  151,  154,  157,  160,
+   164,  167,  170,  173,  177,  180,  184,  187,  190,  194,  198,  201,  205,  208,  212,  216,
+   220,  223,  227,  231,  235,  239,  243,  247,  251,  255,  259,  263,  267,  272,  276,  280,
+   284,  289,  293,  298,  302,  307,  311,  316,  320,  325,  330,  334,  339,  344,  349,  354,
+   359,  364,  369,  374,  379,  384,  389,  394,  399,  405,  410,  415,  421,  426,  431,  437,
+   442,  448,  453,  459,  465,  470,  476,  482,  488,  494,  500,  505,  511,  517,  523,  530,
+   536,  542,  548,  554,  560,  567,  573,  580,  586,  592,  599,  605,  612,  619,  625,  632,
+   639,  646,  652,  659,  666,  673,  680,  687,  694,  701,  708,  715,  723,  730,  737,  745,
+   752,  759,  767,  774,  782,  789,  797,  805,  812,  820,  828,  836,  843,  851,  859,  867,
+   875,  883,  891,  899,  908,  916,  924,  932,  941,  949,  957,  966,  974,  983,  991, 1000,
+};
+_Static_assert(LED_PWM_LEVELS == (sizeof(gamma_) / sizeof(gamma_[0])), "gamma_ must have LED_PWM_LEVELS entries");
+
+static uint16_t ramp_[2 * LED_PWM_RAMP_STEPS_MAX];  /* compare values fed by DMA */
+static bool attached_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void pin_mode_(uint32_t mode)
+{
+  GPIO_InitTypeDef init = {0};
+  init.Pin = LED_PWM_PIN;
+  init.Mode = mode;
+  init.Pull = GPIO_NOPULL;
+  init.Speed = GPIO_SPEED_FREQ_LOW;
+  init.Alternate = TIMER_AF_;
+  HAL_GPIO_Init(LED_PWM_PORT, &init);
+}
+
+static void attach_(void)
+{
+  if(!attached_)
+  {
+    pin_mode_(GPIO_MODE_AF_PP);
+    attached_ = true;
+  }
+}
+
+static void dma_stop_(void)
+{
+  TIMER_->DIER &= ~TIM_DIER_UDE;
+  DMA_STREAM_->CR &= ~DMA_SxCR_EN;
+  while(0 != (DMA_STREAM_->CR & DMA_SxCR_EN))
+  {
+  }
+  DMA_IFCR_ = DMA_IFCR_ALL_;
+}
+
+/* every update event (repetition update events apart) moves one entry of ramp_ to CCR1 */
+static void dma_start_(uint32_t steps, uint32_t repetition, bool circular)
+{
+  TIMER_->RCR = repetition - 1;
+  DMA_STREAM_->PAR = (uint32_t)(uintptr_t)&TIMER_->CCR1;
+  DMA_STREAM_->M0AR = (uint32_t)(uintptr_t)ramp_;
+  DMA_STREAM_->NDTR = steps;
+  DMA_STREAM_->FCR = 0;
+  DMA_STREAM_->CR = (DMA_CHANNEL_ << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0
+                  | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | (circular ? DMA_SxCR_CIRC : 0);
+  DMA_STREAM_->CR |= DMA_SxCR_EN;
+  TIMER_->DIER |= TIM_DIER_UDE;
+}
+
+/* level shown now, also in the middle of a ramp */
+static uint8_t level_now_(void)
+{
+  if(!attached_)
+  {
+    return (GPIO_PIN_RESET != HAL_GPIO_ReadPin(LED_PWM_PORT, LED_PWM_PIN)) ? LED_PWM_LEVEL_MAX : 0;
+  }
+
+  uint32_t ccr = TIMER_->CCR1;
+  uint32_t lo = 0;
+  uint32_t hi = LED_PWM_LEVEL_MAX;
+  while(lo < hi)
+  {
+    uint32_t mid = (lo + hi + 1) / 2;
+    if(gamma_[mid] <= ccr)
+    {
+      lo = mid;
+    }
+    else
+    {
+      hi = mid - 1;
+    }
+  }
+  return (uint8_t)lo;
+}
+
+/* fills steps entries of ramp_ from pramp, last one is level to */
+static void ramp_fill_(uint16_t* pramp, uint8_t from, uint8_t to, uint32_t steps)
+{
+  for(uint32_t i = 0; i < steps; i++)
+  {
+    int32_t level = (int32_t)from + (((int32_t)to - (int32_t)from) * (int32_t)(i + 1)) / (int32_t)steps;
+    pramp[i] = gamma_[level];
+  }
+}
+
+/* splits ms in steps of repetition PWM periods (1 ms each) */
+static uint32_t steps_(uint32_t ms, uint32_t* prepetition)
+{
+  uint32_t steps = (LED_PWM_RAMP_STEPS_MAX < ms) ? LED_PWM_RAMP_STEPS_MAX : ms;
+  uint32_t repetition = ms / steps;
+  *prepetition = (REPETITION_MAX_ < repetition) ? REPETITION_MAX_ : repetition;
+  return steps;
+}
+
+/********************** external functions definition ************************/
+
+bool led_pwm_init(void)
+{
+  __HAL_RCC_TIM8_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  /* APB2 timers run at twice PCLK2 when APB2 is divided */
+  uint32_t clock = HAL_RCC_GetPCLK2Freq();
+  if(0 != (RCC->CFGR & RCC_CFGR_PPRE2_2))
+  {
+    clock *= 2;
+  }
+
+  TIMER_->CR1 = TIM_CR1_ARPE;
+  TIMER_->PSC = (clock / TIMER_TICK_HZ_) - 1;
+  TIMER_->ARR = LED_PWM_PERIOD - 1;
+  TIMER_->CCR1 = 0;
+  TIMER_->CCMR1 = TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1PE;   /* PWM mode 1, preload */
+  TIMER_->CCER = TIM_CCER_CC1NE;                                          /* CH1N = OC1REF */
+  TIMER_->BDTR = TIM_BDTR_MOE;
+  TIMER_->EGR = TIM_EGR_UG;
+  TIMER_->CR1 |= TIM_CR1_CEN;
+
+  attached_ = false;
+  return true;
+}
+
+bool led_pwm_attached(void)
+{
+  return attached_;
+}
+
+bool led_pwm_set(uint8_t level)
+{
+  dma_stop_();
+  TIMER_->CCR1 = gamma_[level];
+  attach_();
+  return true;
+}
+
+bool led_pwm_ramp(uint8_t level, uint32_t ms)
+{
+  if(0 == ms)
+  {
+    return led_pwm_set(level);
+  }
+
+  uint8_t from = level_now_();
+  dma_stop_();
+
+  uint32_t repetition;
+  uint32_t steps = steps_(ms, &repetition);
+  ramp_fill_(ramp_, from, level, steps);
+
+  TIMER_->CCR1 = gamma_[from];
+  attach_();
+  dma_start_(steps, repetition, false);
+  return true;
+}
+
+bool led_pwm_breathe(uint8_t level, uint32_t period_ms)
+{
+  uint32_t half_ms = period_ms / 2;
+  if(0 == half_ms)
+  {
+    return led_pwm_set(level);
+  }
+
+  dma_stop_();
+
+  uint32_t repetition;
+  uint32_t steps = steps_(half_ms, &repetition);
+  ramp_fill_(&ramp_[0], 0, level, steps);
+  ramp_fill_(&ramp_[steps], level, 0, steps);
+
+  TIMER_->CCR1 = 0;
+  attach_();
+  dma_start_(2 * steps, repetition, true);
+  return true;
+}
+
+void led_pwm_detach(void)
+{
+  if(attached_)
+  {
+    dma_stop_();
+    pin_mode_(GPIO_MODE_OUTPUT_PP);
+    attached_ = false;
+  }
+}
+
+#else
+
+bool led_pwm_init(void)
+{
+  return false;
+}
+
+bool led_pwm_attached(void)
+{
+  return false;
+}
+
+bool led_pwm_set(uint8_t level)
+{
+  (void)level;
+  return false;
+}
+
+bool led_pwm_ramp(uint8_t level, uint32_t ms)
+{
+  (void)level;
+  (void)ms;
+  return false;
+}
+
+bool led_pwm_breathe(uint8_t level, uint32_t period_ms)
+{
+  (void)level;
+  (void)period_ms;
+  return false;
+}
+
+void led_pwm_detach(void)
+{
+}
+
+#endif /* defined(LED_PWM_PIN) */
+
+/********************** end of file ******************************************/
@@ -61,77 +61,112 @@ void linked_list_init(linked_list_t* hlist)
   hlist->len = 0;
 }
 
-void linked_list_node_init(linked_list_node_t* hnode, void* pdata)
+void linked_list_node_init(linked_list_node_t* hnode)
 {
-  hnode->pdata = pdata;
   hnode->pnext_node = NULL;
+  hnode->pprev_node = NULL;
 }
 
 linked_list_node_t* linked_list_node_remove(linked_list_t* hlist)
 {
-  linked_list_node_t* hnode;
-  if(0 == hlist->len)
+  linked_list_node_t* hnode = hlist->pfirst_node;
+  if(NULL != hnode)
   {
-    hnode = NULL;
+    linked_list_node_unlink(hlist, hnode);
   }
-  else if(1 == hlist->len)
+  return hnode;
+}
+
+void linked_list_node_add(linked_list_t* hlist, linked_list_node_t* hnode)
+{
+  if(NULL == hlist->plast_node)
   {
-    hnode = hlist->pfirst_node;
-    hlist->pfirst_node = NULL;
-    hlist->plast_node = NULL;
-    hnode->pnext_node = NULL;
-    hlist->len--;
+    linked_list_node_init(hnode);
+    hlist->pfirst_node = hnode;
+    hlist->plast_node = hnode;
+    hlist->len++;
   }
   else
   {
-    hnode = hlist->pfirst_node;
-    hlist->pfirst_node = hnode->pnext_node;
-    hnode->pnext_node = NULL;
-    hlist->len--;
+    linked_list_node_insert_after(hlist, hlist->plast_node, hnode);
   }
-  return hnode;
 }
 
-void linked_list_node_add(linked_list_t* hlist, linked_list_node_t* hnode)
+void linked_list_node_insert_after(linked_list_t* hlist, linked_list_node_t* hpos, linked_list_node_t* hnode)
 {
-  if(0 == hlist->len)
+  hnode->pprev_node = hpos;
+  hnode->pnext_node = hpos->pnext_node;
+  if(NULL == hpos->pnext_node)
   {
-    hlist->pfirst_node = hnode;
     hlist->plast_node = hnode;
   }
   else
   {
-    hlist->plast_node->pnext_node = hnode;
-    hlist->plast_node = hnode;
+    hpos->pnext_node->pprev_node = hnode;
   }
+  hpos->pnext_node = hnode;
   hlist->len++;
 }
 
-linked_list_node_t* linked_list_node_remove_by_id(linked_list_t* hlist, int id)
+void linked_list_node_insert_before(linked_list_t* hlist, linked_list_node_t* hpos, linked_list_node_t* hnode)
+{
+  hnode->pnext_node = hpos;
+  hnode->pprev_node = hpos->pprev_node;
+  if(NULL == hpos->pprev_node)
+  {
+    hlist->pfirst_node = hnode;
+  }
+  else
+  {
+    hpos->pprev_node->pnext_node = hnode;
+  }
+  hpos->pprev_node = hnode;
+  hlist->len++;
+}
+
+void linked_list_node_unlink(linked_list_t* hlist, linked_list_node_t* hnode)
+{
+  if(NULL == hnode->pprev_node)
+  {
+    hlist->pfirst_node = hnode->pnext_node;
+  }
+  else
+  {
+    hnode->pprev_node->pnext_node = hnode->pnext_node;
+  }
+
+  if(NULL == hnode->pnext_node)
+  {
+    hlist->plast_node = hnode->pprev_node;
+  }
+  else
+  {
+    hnode->pnext_node->pprev_node = hnode->pprev_node;
+  }
+
+  linked_list_node_init(hnode);
+  hlist->len--;
+}
+
+void linked_list_splice(linked_list_t* hlist, linked_list_t* hsrc)
 {
-    linked_list_node_t* prev = NULL;
-    linked_list_node_t* node = hlist->pfirst_node;
-    while (node != NULL) {
-        // Se asume que pdata apunta a una struct que tiene un campo int id
-        int* entry_id = (int*)node->pdata;
-        if (*entry_id == id) {
-            // Eliminar nodo de la lista
-            if (prev == NULL) {
-                hlist->pfirst_node = node->pnext_node;
-            } else {
-                prev->pnext_node = node->pnext_node;
-            }
-            if (node == hlist->plast_node) {
-                hlist->plast_node = prev;
-            }
-            hlist->len--;
-            node->pnext_node = NULL;
-            return node;
-        }
-        prev = node;
-        node = node->pnext_node;
-    }
-    return NULL;
+  if(NULL == hsrc->pfirst_node)
+  {
+    return;
+  }
+
+  if(NULL == hlist->plast_node)
+  {
+    hlist->pfirst_node = hsrc->pfirst_node;
+  }
+  else
+  {
+    hlist->plast_node->pnext_node = hsrc->pfirst_node;
+    hsrc->pfirst_node->pprev_node = hlist->plast_node;
+  }
+  hlist->plast_node = hsrc->plast_node;
+  hlist->len += hsrc->len;
+  linked_list_init(hsrc);
 }
 
 /********************** end of file ******************************************/
@@ -40,42 +40,383 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdarg.h>
 #include <string.h>
 
 #include "main.h"
 #include "cmsis_os.h"
 
 #include "logger.h"
+#include "atomic_ops.h"
+#include "uart_tx.h"
+#include "dwt.h"
+#include "crash_log.h"
 
 /********************** macros and definitions *******************************/
 
+#define QUEUE_MASK_               (LOGGER_CONFIG_QUEUE_LEN - 1)
+
+#if 0 != (LOGGER_CONFIG_QUEUE_LEN & QUEUE_MASK_)
+#error "LOGGER_CONFIG_QUEUE_LEN must be a power of two"
+#endif
+
+/*
+ * Tokenized frame, little endian:
+ *   [0xA5][nargs][token x2][timestamp x8][context x4][arg0 x4]...[argN x4]
+ */
+#define FRAME_SYNC_               (0xA5)
+#define FRAME_HEADER_SIZE_        (16)
+
+#define CONTEXT_ISR_MAX_          (256) // contexts below this are exception numbers
+#define FRAME_MAXLEN_             (FRAME_HEADER_SIZE_ + (4 * LOGGER_CONFIG_MAXARGS))
+
 /********************** internal data declaration ****************************/
 
+/*
+ * Bounded multi-producer / single-consumer queue. Each slot carries a
+ * sequence number: seq == pos means free for the producer that reserves pos,
+ * seq == pos + 1 means committed and ready for the logger task.
+ */
+typedef struct
+{
+    volatile uint32_t seq;
+    logger_record_t record;
+} logger_slot_t;
+
 /********************** internal functions declaration ***********************/
 
 /********************** internal data definition *****************************/
 
-/********************** external data definition *****************************/
+static struct
+{
+    volatile uint32_t head;
+    uint32_t tail;
+    volatile uint32_t dropped;
+    logger_slot_t slot[LOGGER_CONFIG_QUEUE_LEN];
+} logger_;
+
+static TaskHandle_t htask_;
 
 static char logger_msg_buffer_[LOGGER_CONFIG_MAXLEN];
-char* const logger_msg = logger_msg_buffer_;
-int logger_msg_len;
+static char* const logger_msg = logger_msg_buffer_;
+static int logger_msg_len; // only for debug information
+
+/********************** external data definition *****************************/
 
 /********************** internal functions definition ************************/
 
+static void frame_put_u32_(uint8_t* pframe, uint32_t value)
+{
+  pframe[0] = (uint8_t)(value >> 0);
+  pframe[1] = (uint8_t)(value >> 8);
+  pframe[2] = (uint8_t)(value >> 16);
+  pframe[3] = (uint8_t)(value >> 24);
+}
+
+static logger_slot_t* slot_reserve_(uint32_t* ppos)
+{
+  uint32_t pos;
+  logger_slot_t* pslot;
+  while(true)
+  {
+    pos = logger_.head;
+    pslot = &logger_.slot[pos & QUEUE_MASK_];
+    int32_t diff = (int32_t)(pslot->seq - pos);
+    if(0 == diff)
+    {
+      if(atomic_ops_cas_u32(&logger_.head, pos, pos + 1))
+      {
+        *ppos = pos;
+        return pslot;
+      }
+    }
+    else if(diff < 0)
+    {
+      atomic_ops_add_u32(&logger_.dropped, 1);
+      return NULL;
+    }
+  }
+}
+
+/*
+ * FreeRTOS calls are only legal from tasks and from ISRs at or below
+ * configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY. Records from anywhere else
+ * (faults, masked code, fast ISRs) wait for the task's idle timeout.
+ */
+static bool wake_allowed_(void)
+{
+  if((NULL == htask_) || (0 != __get_PRIMASK()) || (taskSCHEDULER_NOT_STARTED == xTaskGetSchedulerState()))
+  {
+    return false;
+  }
+  uint32_t ipsr = __get_IPSR();
+  if(0 == ipsr)
+  {
+    return true;
+  }
+  if(16 > ipsr)
+  {
+    return false;
+  }
+  return configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY <= NVIC_GetPriority((IRQn_Type)(ipsr - 16));
+}
+
+static void task_wake_(void)
+{
+  if(!wake_allowed_())
+  {
+    return;
+  }
+  if(0 != __get_IPSR())
+  {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(htask_, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+  }
+  else
+  {
+    xTaskNotifyGive(htask_);
+  }
+}
+
+static void slot_commit_(logger_slot_t* pslot, uint32_t pos)
+{
+  __DMB();
+  pslot->seq = pos + 1;
+  task_wake_();
+}
+
+static bool record_pop_(logger_record_t* precord)
+{
+  logger_slot_t* pslot = &logger_.slot[logger_.tail & QUEUE_MASK_];
+  if((logger_.tail + 1) != pslot->seq)
+  {
+    return false;
+  }
+  *precord = pslot->record;
+  __DMB();
+  pslot->seq = logger_.tail + LOGGER_CONFIG_QUEUE_LEN;
+  logger_.tail++;
+  return true;
+}
+
+#if 1 == LOGGER_CONFIG_USE_TOKENS
+static void record_print_(const logger_record_t* precord)
+{
+  uint8_t frame[FRAME_MAXLEN_];
+  uint32_t token = (uint32_t)(uintptr_t)precord->fmt;
+  size_t len = 0;
+
+  frame[len++] = FRAME_SYNC_;
+  frame[len++] = (uint8_t)precord->nargs;
+  frame[len++] = (uint8_t)(token >> 0);
+  frame[len++] = (uint8_t)(token >> 8);
+  frame_put_u32_(&frame[len], (uint32_t)(precord->timestamp >> 0));
+  len += 4;
+  frame_put_u32_(&frame[len], (uint32_t)(precord->timestamp >> 32));
+  len += 4;
+  frame_put_u32_(&frame[len], precord->context);
+  len += 4;
+  for(uint32_t i = 0; i < precord->nargs; ++i)
+  {
+    frame_put_u32_(&frame[len], precord->args[i]);
+    len += 4;
+  }
+  logger_log_write_(frame, len);
+}
+#else
+static void record_print_(const logger_record_t* precord)
+{
+  _Static_assert(4 == LOGGER_CONFIG_MAXARGS, "record_print_ expects 4 argument words");
+
+  uint64_t us = precord->timestamp / cycles_per_us;
+  unsigned long sec = (unsigned long)(us / 1000000);
+  unsigned long usec = (unsigned long)(us % 1000000);
+  int len;
+  if(0 == precord->context)
+  {
+    len = snprintf(logger_msg, (LOGGER_CONFIG_MAXLEN - 1), "[%4lu.%06lu][main] ", sec, usec);
+  }
+  else if(CONTEXT_ISR_MAX_ > precord->context)
+  {
+    len = snprintf(logger_msg, (LOGGER_CONFIG_MAXLEN - 1), "[%4lu.%06lu][isr %lu] ", sec, usec,
+                   (unsigned long)precord->context);
+  }
+  else
+  {
+    len = snprintf(logger_msg, (LOGGER_CONFIG_MAXLEN - 1), "[%4lu.%06lu][%08lx] ", sec, usec,
+                   (unsigned long)precord->context);
+  }
+
+  logger_msg_len = len + snprintf(&logger_msg[len], (LOGGER_CONFIG_MAXLEN - 1) - len, precord->fmt,
+                                  precord->args[0], precord->args[1], precord->args[2], precord->args[3]);
+  logger_log_print_(logger_msg);
+}
+#endif
+
+static void task_(void *argument)
+{
+  (void)argument;
+  uint32_t dropped_reported = 0;
+  while(true)
+  {
+    logger_record_t record;
+    while(record_pop_(&record))
+    {
+      record_print_(&record);
+      crash_log_record(&record);
+    }
+
+    uint32_t dropped = logger_.dropped;
+    if(dropped != dropped_reported)
+    {
+      LOGGER_FMT_DEFINE_(dropped_fmt_, "[logger] %lu records dropped\n");
+      record.timestamp = cycle_counter_get_64();
+      record.context = logger_context_get();
+      record.fmt = LOGGER_FMT_REF_(dropped_fmt_, "[logger] %lu records dropped\n");
+      record.nargs = 1;
+      record.args[0] = dropped - dropped_reported;
+      record_print_(&record);
+      dropped_reported = dropped;
+    }
+
+    ulTaskNotifyTake(pdTRUE, (TickType_t)(LOGGER_CONFIG_TASK_IDLE_MS / portTICK_PERIOD_MS));
+  }
+}
+
 /********************** external functions definition ************************/
 
-#if 1 == LOGGER_CONFIG_USE_SEMIHOSTING
+/* exception number in an ISR, else the running task (0 before the scheduler) */
+uint32_t logger_context_get(void)
+{
+  uint32_t ipsr = __get_IPSR();
+  if(0 != ipsr)
+  {
+    return ipsr;
+  }
+  if(taskSCHEDULER_NOT_STARTED == xTaskGetSchedulerState())
+  {
+    return 0;
+  }
+  return (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle();
+}
+
+void logger_init(void)
+{
+  logger_.head = 0;
+  logger_.tail = 0;
+  logger_.dropped = 0;
+  for(uint32_t i = 0; i < LOGGER_CONFIG_QUEUE_LEN; ++i)
+  {
+    logger_.slot[i].seq = i;
+  }
+
+  BaseType_t status;
+  status = xTaskCreate(task_, "task_logger", LOGGER_CONFIG_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY, &htask_);
+  while (pdPASS != status)
+  {
+    // error
+  }
+}
+
+/*
+ * Safe from tasks and from ISRs of any priority: a slot is reserved with a
+ * LDREX/STREX compare-and-swap on head, so interrupts are never masked and a
+ * full queue drops the record instead of blocking.
+ */
+bool logger_log_(uint32_t nargs, const char* fmt, ...)
+{
+  uint64_t timestamp = cycle_counter_get_64();
+  uint32_t pos;
+  logger_slot_t* pslot = slot_reserve_(&pos);
+  if(NULL == pslot)
+  {
+    return false;
+  }
+
+  logger_record_t* precord = &pslot->record;
+  precord->timestamp = timestamp;
+  precord->context = logger_context_get();
+  precord->fmt = fmt;
+  precord->nargs = nargs;
+
+  va_list ap;
+  va_start(ap, fmt);
+  for(uint32_t i = 0; i < LOGGER_CONFIG_MAXARGS; ++i)
+  {
+    precord->args[i] = (i < nargs) ? va_arg(ap, uint32_t) : 0;
+  }
+  va_end(ap);
+
+  slot_commit_(pslot, pos);
+  return true;
+}
+
+/* queues an already built record, keeping its original stamp and context */
+bool logger_replay(const logger_record_t* precord)
+{
+  uint32_t pos;
+  logger_slot_t* pslot = slot_reserve_(&pos);
+  if(NULL == pslot)
+  {
+    return false;
+  }
+  pslot->record = *precord;
+  slot_commit_(pslot, pos);
+  return true;
+}
+
+/* walks the committed records not yet printed, oldest first (fault path) */
+void logger_pending_foreach(void (*callback)(const logger_record_t*))
+{
+  for(uint32_t pos = logger_.tail; pos != logger_.head; ++pos)
+  {
+    logger_slot_t* pslot = &logger_.slot[pos & QUEUE_MASK_];
+    if((pos + 1) != pslot->seq)
+    {
+      break;
+    }
+    callback(&pslot->record);
+  }
+}
+
+uint32_t logger_dropped(void)
+{
+  return logger_.dropped;
+}
+
+#if 1 == LOGGER_CONFIG_USE_UART
+void logger_log_print_(char* const msg)
+{
+  uart_tx_write(msg, strlen(msg));
+}
+
+void logger_log_write_(const void* data, size_t len)
+{
+  uart_tx_write(data, len);
+}
+#elif 1 == LOGGER_CONFIG_USE_SEMIHOSTING
 void logger_log_print_(char* const msg)
 {
 	printf(msg);
 	fflush(stdout);
 }
+
+void logger_log_write_(const void* data, size_t len)
+{
+	fwrite(data, 1, len, stdout);
+	fflush(stdout);
+}
 #else
 void logger_log_print_(char* const msg)
 {
     return;
 }
+
+void logger_log_write_(const void* data, size_t len)
+{
+    return;
+}
 #endif
 
 /********************** end of file ******************************************/
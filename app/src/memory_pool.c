@@ -41,6 +41,7 @@
 #include "main.h"
 #include "cmsis_os.h"
 #include "memory_pool.h"
+#include "atomic_ops.h"
 
 /********************** macros and definitions *******************************/
 
@@ -54,40 +55,391 @@
 
 /********************** internal functions definition ************************/
 
+static void high_water_update_(memory_pool_t* hmp, uint32_t in_use)
+{
+  uint32_t high_water;
+  do
+  {
+    high_water = hmp->high_water;
+    if(in_use <= high_water)
+    {
+      return;
+    }
+  } while(!atomic_ops_cas_u32(&hmp->high_water, high_water, in_use));
+}
+
+/*
+ * Pop from the free stack. The pnext read sits inside the LDREX/STREX window,
+ * so if the top block is taken and put back meanwhile (ABA) the STREX fails:
+ * the exception entry/return of whoever did it cleared the exclusive monitor.
+ */
+static void* block_pop_(memory_pool_t* hmp)
+{
+  memory_pool_block_t* pblock;
+  do
+  {
+    pblock = (memory_pool_block_t*)(uintptr_t)__LDREXW((volatile uint32_t*)&hmp->ptop);
+    if(NULL == pblock)
+    {
+      __CLREX();
+      return NULL;
+    }
+  } while(0 != __STREXW((uint32_t)(uintptr_t)pblock->pnext, (volatile uint32_t*)&hmp->ptop));
+  __DMB();
+  return (void*)pblock;
+}
+
+static void block_push_(memory_pool_t* hmp, void* pblock)
+{
+  memory_pool_block_t* pnode = (memory_pool_block_t*)pblock;
+  __DMB();
+  do
+  {
+    pnode->pnext = (memory_pool_block_t*)(uintptr_t)__LDREXW((volatile uint32_t*)&hmp->ptop);
+  } while(0 != __STREXW((uint32_t)(uintptr_t)pnode, (volatile uint32_t*)&hmp->ptop));
+}
+
+/* pops up to n blocks with a single STREX, the chain is walked inside the window */
+static uint32_t block_pop_batch_(memory_pool_t* hmp, void** ppblock, uint32_t n)
+{
+  memory_pool_block_t* pfirst;
+  memory_pool_block_t* plast;
+  uint32_t count;
+  do
+  {
+    pfirst = (memory_pool_block_t*)(uintptr_t)__LDREXW((volatile uint32_t*)&hmp->ptop);
+    if(NULL == pfirst)
+    {
+      __CLREX();
+      return 0;
+    }
+    plast = pfirst;
+    count = 1;
+    while((count < n) && (NULL != plast->pnext))
+    {
+      plast = plast->pnext;
+      count++;
+    }
+  } while(0 != __STREXW((uint32_t)(uintptr_t)plast->pnext, (volatile uint32_t*)&hmp->ptop));
+  __DMB();
+
+  for(uint32_t i = 0; i < count; ++i)
+  {
+    ppblock[i] = pfirst;
+    pfirst = pfirst->pnext;
+  }
+  return count;
+}
+
+/* links the n blocks into a chain and pushes it with a single STREX */
+static void block_push_batch_(memory_pool_t* hmp, void* const* ppblock, uint32_t n)
+{
+  for(uint32_t i = 0; i + 1 < n; ++i)
+  {
+    ((memory_pool_block_t*)ppblock[i])->pnext = (memory_pool_block_t*)ppblock[i + 1];
+  }
+  memory_pool_block_t* plast = (memory_pool_block_t*)ppblock[n - 1];
+  __DMB();
+  do
+  {
+    plast->pnext = (memory_pool_block_t*)(uintptr_t)__LDREXW((volatile uint32_t*)&hmp->ptop);
+  } while(0 != __STREXW((uint32_t)(uintptr_t)ppblock[0], (volatile uint32_t*)&hmp->ptop));
+}
+
+static void waiters_wake_(memory_pool_t* hmp)
+{
+  if((NULL != hmp->hsem) && (0 != hmp->waiters))
+  {
+    if(0 != __get_IPSR())
+    {
+      BaseType_t higher_priority_task_woken = pdFALSE;
+      xSemaphoreGiveFromISR(hmp->hsem, &higher_priority_task_woken);
+      portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
+    else
+    {
+      xSemaphoreGive(hmp->hsem);
+    }
+  }
+}
+
+/* the calling task's magazine if it caches hmp, never from an ISR */
+static memory_pool_magazine_t* magazine_(memory_pool_t* hmp)
+{
+  if((0 != __get_IPSR()) || (taskSCHEDULER_NOT_STARTED == xTaskGetSchedulerState()))
+  {
+    return NULL;
+  }
+  memory_pool_magazine_t* pmagazine = pvTaskGetThreadLocalStoragePointer(NULL, MEMORY_POOL_TLS_INDEX);
+  return ((NULL != pmagazine) && (hmp == pmagazine->hmp)) ? pmagazine : NULL;
+}
+
+/* takes a block never handed out yet */
+static void* block_fresh_(memory_pool_t* hmp)
+{
+  uint8_t* pfresh;
+  do
+  {
+    pfresh = hmp->pfresh;
+    if(hmp->pend <= pfresh)
+    {
+      return NULL;
+    }
+  } while(!atomic_ops_cas_u32((volatile uint32_t*)&hmp->pfresh, (uint32_t)(uintptr_t)pfresh, (uint32_t)(uintptr_t)(pfresh + hmp->stride)));
+  return (void*)(pfresh + MEMORY_POOL_HEADER_SIZE);
+}
+
+static memory_pool_header_t* header_(const void* pblock)
+{
+  return (memory_pool_header_t*)pblock - 1;
+}
+
+#if 1 == MEMORY_POOL_CONFIG_DEBUG
+static void* owner_get_(void)
+{
+  if((0 != __get_IPSR()) || (taskSCHEDULER_NOT_STARTED == xTaskGetSchedulerState()))
+  {
+    return NULL;
+  }
+  return (void*)xTaskGetCurrentTaskHandle();
+}
+#endif
+
 /********************** external functions definition ************************/
 
 void memory_pool_init(memory_pool_t* hmp, void* pmemory, size_t nblocks, size_t block_size)
 {
-  linked_list_t* hlist = &(hmp->block_list);
-  linked_list_init(hlist);
+  configASSERT(0 == ((uintptr_t)pmemory % MEMORY_POOL_ALIGN));
+
+  hmp->ptop = NULL;
+  hmp->pmemory = (uint8_t*)pmemory;
+  hmp->pfresh = hmp->pmemory;
+  hmp->pend = hmp->pmemory + MEMORY_POOL_SIZE(nblocks, block_size);
+  hmp->stride = MEMORY_POOL_BLOCK_STRIDE(block_size);
+  hmp->nblocks = nblocks;
+  hmp->in_use = 0;
+  hmp->high_water = 0;
+  hmp->gets = 0;
+  hmp->puts = 0;
+  hmp->failed = 0;
+  hmp->waiters = 0;
+  hmp->hsem = NULL;
+}
+
+static void* magazine_get_(memory_pool_t* hmp)
+{
+  memory_pool_magazine_t* pmagazine = magazine_(hmp);
+  if(NULL == pmagazine)
+  {
+    return NULL;
+  }
+
+  if(0 == pmagazine->count)
+  {
+    const uint32_t half = MEMORY_POOL_CONFIG_MAGAZINE_SIZE / 2;
+    pmagazine->count = block_pop_batch_(hmp, pmagazine->pblock, half);
+    while(pmagazine->count < half)
+    {
+      void* pblock = block_fresh_(hmp);
+      if(NULL == pblock)
+      {
+        break;
+      }
+      pmagazine->pblock[pmagazine->count++] = pblock;
+    }
+    if(0 == pmagazine->count)
+    {
+      return NULL;
+    }
+  }
+  return pmagazine->pblock[--pmagazine->count];
+}
+
+/* a task waiting on the shared pool takes precedence over the cache */
+static bool magazine_put_(memory_pool_t* hmp, void* pblock)
+{
+  memory_pool_magazine_t* pmagazine = magazine_(hmp);
+  if((NULL == pmagazine) || (0 != hmp->waiters))
+  {
+    return false;
+  }
+
+  if(MEMORY_POOL_CONFIG_MAGAZINE_SIZE == pmagazine->count)
+  {
+    const uint32_t half = MEMORY_POOL_CONFIG_MAGAZINE_SIZE / 2;
+    pmagazine->count -= half;
+    block_push_batch_(hmp, &pmagazine->pblock[pmagazine->count], half);
+  }
+  pmagazine->pblock[pmagazine->count++] = pblock;
+  return true;
+}
 
-  for(size_t i = 0; i < nblocks; ++i)
+static void* block_get_(memory_pool_t* hmp)
+{
+  void* pblock = magazine_get_(hmp);
+  if(NULL == pblock)
+  {
+    pblock = block_pop_(hmp);
+  }
+  if(NULL == pblock)
   {
-    void* pblock = pmemory + i*block_size;
-    linked_list_node_init((memory_pool_block_t*)pblock, NULL);
-    linked_list_node_add(hlist, pblock);
+    pblock = block_fresh_(hmp);
   }
+  if(NULL == pblock)
+  {
+    return NULL;
+  }
+
+  atomic_ops_add_u32(&hmp->gets, 1);
+  high_water_update_(hmp, atomic_ops_add_u32(&hmp->in_use, 1));
+  header_(pblock)->refs = 1;
+#if 1 == MEMORY_POOL_CONFIG_DEBUG
+  header_(pblock)->owner = owner_get_();
+  header_(pblock)->timestamp = HAL_GetTick();
+#endif
+  return pblock;
 }
 
 void* memory_pool_block_get(memory_pool_t* hmp)
 {
-  portENTER_CRITICAL();
-  linked_list_t* hlist = &(hmp->block_list);
-  void* pblock = (void*)linked_list_node_remove(hlist);
-  portEXIT_CRITICAL();
+  void* pblock = block_get_(hmp);
+  if(NULL == pblock)
+  {
+    atomic_ops_add_u32(&hmp->failed, 1);
+  }
+  return pblock;
+}
+
+/*
+ * The semaphore only signals "a block was put back", the free list stays the
+ * lock-free stack. A waiter registers before re-checking the list, so a put
+ * between the check and the take is never missed; stale gives just cost one
+ * extra turn of the loop.
+ */
+void* memory_pool_block_get_timeout(memory_pool_t* hmp, TickType_t timeout)
+{
+  void* pblock = block_get_(hmp);
+  if((NULL != pblock) || (NULL == hmp->hsem) || (0 == timeout))
+  {
+    if(NULL == pblock)
+    {
+      atomic_ops_add_u32(&hmp->failed, 1);
+    }
+    return pblock;
+  }
+
+  TimeOut_t time_out;
+  vTaskSetTimeOutState(&time_out);
+  atomic_ops_add_u32(&hmp->waiters, 1);
+  while(true)
+  {
+    pblock = block_get_(hmp);
+    if((NULL != pblock) || (pdFALSE != xTaskCheckForTimeOut(&time_out, &timeout)))
+    {
+      break;
+    }
+    xSemaphoreTake(hmp->hsem, timeout);
+  }
+  atomic_ops_add_u32(&hmp->waiters, -1u);
+
+  if(NULL == pblock)
+  {
+    atomic_ops_add_u32(&hmp->failed, 1);
+  }
   return pblock;
 }
 
 void memory_pool_block_put(memory_pool_t* hmp, void* pblock)
 {
-  portENTER_CRITICAL();
-  if(NULL != pblock)
+  if(NULL == pblock)
+  {
+    return;
+  }
+
+  header_(pblock)->refs = 0;
+  atomic_ops_add_u32(&hmp->puts, 1);
+  atomic_ops_add_u32(&hmp->in_use, -1u);
+  if(magazine_put_(hmp, pblock))
+  {
+    return;
+  }
+  block_push_(hmp, pblock);
+  waiters_wake_(hmp);
+}
+
+void memory_pool_block_ref(void* pblock)
+{
+  atomic_ops_add_u32(&header_(pblock)->refs, 1);
+}
+
+bool memory_pool_block_release(memory_pool_t* hmp, void* pblock)
+{
+  if(NULL == pblock)
+  {
+    return false;
+  }
+  if(0 != atomic_ops_add_u32(&header_(pblock)->refs, -1u))
+  {
+    return false;
+  }
+  memory_pool_block_put(hmp, pblock);
+  return true;
+}
+
+void memory_pool_blocking_init(memory_pool_t* hmp, StaticSemaphore_t* psem_buffer)
+{
+  hmp->hsem = xSemaphoreCreateCountingStatic(hmp->nblocks, 0, psem_buffer);
+}
+
+void memory_pool_magazine_attach(memory_pool_t* hmp, memory_pool_magazine_t* pmagazine)
+{
+  memory_pool_magazine_detach();
+  pmagazine->hmp = hmp;
+  pmagazine->count = 0;
+  vTaskSetThreadLocalStoragePointer(NULL, MEMORY_POOL_TLS_INDEX, pmagazine);
+}
+
+void memory_pool_magazine_detach(void)
+{
+  memory_pool_magazine_t* pmagazine = pvTaskGetThreadLocalStoragePointer(NULL, MEMORY_POOL_TLS_INDEX);
+  if(NULL == pmagazine)
+  {
+    return;
+  }
+  vTaskSetThreadLocalStoragePointer(NULL, MEMORY_POOL_TLS_INDEX, NULL);
+  if(0 != pmagazine->count)
+  {
+    block_push_batch_(pmagazine->hmp, pmagazine->pblock, pmagazine->count);
+    pmagazine->count = 0;
+    waiters_wake_(pmagazine->hmp);
+  }
+}
+
+void memory_pool_stats(const memory_pool_t* hmp, memory_pool_stats_t* pstats)
+{
+  pstats->nblocks = hmp->nblocks;
+  pstats->in_use = hmp->in_use;
+  pstats->high_water = hmp->high_water;
+  pstats->gets = hmp->gets;
+  pstats->puts = hmp->puts;
+  pstats->failed = hmp->failed;
+  pstats->waiters = hmp->waiters;
+}
+
+#if 1 == MEMORY_POOL_CONFIG_DEBUG
+void memory_pool_foreach_used(const memory_pool_t* hmp, void (*callback)(const void* pblock, const memory_pool_header_t* pheader))
+{
+  /* blocks past pfresh were never handed out */
+  for(const uint8_t* p = hmp->pmemory; p < hmp->pfresh; p += hmp->stride)
   {
-    linked_list_t* hlist = &(hmp->block_list);
-    linked_list_node_init((memory_pool_block_t*)pblock, NULL);
-    linked_list_node_add(hlist, pblock);
+    const void* pblock = p + MEMORY_POOL_HEADER_SIZE;
+    const memory_pool_header_t* pheader = header_(pblock);
+    if(0 != pheader->refs)
+    {
+      callback(pblock, pheader);
+    }
   }
-  portEXIT_CRITICAL();
 }
+#endif
 
 /********************** end of file ******************************************/
@@ -34,6 +34,8 @@
 
 /********************** inclusions *******************************************/
 
+#define LOGGER_MODULE_LEVEL       (LOGGER_LEVEL_INFO)
+
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -43,17 +45,16 @@
 #include "board.h"
 #include "logger.h"
 #include "dwt.h"
+#include "journal.h"
+#include "crash_log.h"
+#include "button_scan.h"
+#include "button_gesture.h"
 
 #include "task_ui.h"
 
 /********************** macros and definitions *******************************/
 
-#define TASK_PERIOD_MS_           (50)
-
-#define BUTTON_PERIOD_MS_         (TASK_PERIOD_MS_)
-#define BUTTON_PULSE_TIMEOUT_     (200)
-#define BUTTON_SHORT_TIMEOUT_     (1000)
-#define BUTTON_LONG_TIMEOUT_      (2000)
+#define BUTTON_IRQ_PRIORITY_      (6)    // >= configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, usa la API FromISR
 
 /********************** internal data declaration ****************************/
 
@@ -61,94 +62,104 @@
 
 /********************** internal data definition *****************************/
 
-/********************** external data definition *****************************/
+// los botones de board.h; si comparten pin, comparten id
+static GPIO_TypeDef* const button_port_[] = {BUTTON_A_PORT, BUTTON_B_PORT, BUTTON_C_PORT};
+static const uint16_t button_pin_[] = {BUTTON_A_PIN, BUTTON_B_PIN, BUTTON_C_PIN};
 
-extern SemaphoreHandle_t hsem_button;
+static uint32_t press_cycles_[BUTTON_SCAN_BUTTONS_MAX];
+
+/********************** external data definition *****************************/
 
 /********************** internal functions definition ************************/
 
-typedef enum
-{
-  BUTTON_TYPE_NONE,
-  BUTTON_TYPE_PULSE,
-  BUTTON_TYPE_SHORT,
-  BUTTON_TYPE_LONG,
-  BUTTON_TYPE__N,
-} button_type_t;
-
-static struct
+// el gesto se informa apenas se cruza el umbral, SHORT y LONG con el boton todavia apretado
+static void button_gesture_(uint8_t button, button_gesture_t gesture)
 {
-    uint32_t counter;
-} button;
+  msg_event_t event;
+  switch (gesture) {
+    case BUTTON_GESTURE_CLICK:
+      LOGGER_INFO("button pulse");
+      event = MSG_EVENT_BUTTON_PULSE;
+      break;
+    case BUTTON_GESTURE_SHORT:
+      LOGGER_INFO("button short");
+      event = MSG_EVENT_BUTTON_SHORT;
+      break;
+    case BUTTON_GESTURE_LONG:
+      LOGGER_INFO("button long");
+      event = MSG_EVENT_BUTTON_LONG;
+      break;
+    case BUTTON_GESTURE_DOUBLE_CLICK:
+      LOGGER_INFO("button double");
+      event = MSG_EVENT_BUTTON_DOUBLE;
+      break;
+    case BUTTON_GESTURE_TRIPLE_CLICK:
+      LOGGER_INFO("button triple");
+      event = MSG_EVENT_BUTTON_TRIPLE;
+      break;
+    case BUTTON_GESTURE_REPEAT:
+      LOGGER_TRACE("\t\tBOTON %u REPETICION", (unsigned int)button);
+      return;
+    default:
+      LOGGER_ERROR("button error");
+      return;
+  }
 
-static void button_init_(void)
-{
-  button.counter = 0;
+  // solo se registra lo que la UI realmente recibio
+  if(!ao_ui_send_event(event))
+  {
+    LOGGER_WARN("button: ui mailbox full, event %u dropped", (unsigned int)event);
+    return;
+  }
+  journal_append(JOURNAL_EVENT_BUTTON, event);
 }
 
-static button_type_t button_process_state_(bool value)
+// corre en la tarea de timers, igual que los timers de gestos
+static void button_event_(uint8_t button, button_scan_event_t event, uint32_t cycles)
 {
-  button_type_t ret = BUTTON_TYPE_NONE;
-  if(value)
-  {
-    button.counter += BUTTON_PERIOD_MS_;
-    // LOGGER_INFO("\t\t(%d) BOTON PRESIONADO - %d ms", (int)HAL_GetTick(),(int)button.counter);
-  }
-  else
-  {
-    if(BUTTON_LONG_TIMEOUT_ <= button.counter)
-    {
-      ret = BUTTON_TYPE_LONG;
-    }
-    else if(BUTTON_SHORT_TIMEOUT_ <= button.counter)
-    {
-      ret = BUTTON_TYPE_SHORT;
-    }
-    else if(BUTTON_PULSE_TIMEOUT_ <= button.counter)
-    {
-      ret = BUTTON_TYPE_PULSE;
-    }
-    button.counter = 0;
+  switch (event) {
+    case BUTTON_SCAN_EVENT_PRESS:
+      press_cycles_[button] = cycles;
+      break;
+    case BUTTON_SCAN_EVENT_RELEASE:
+      LOGGER_TRACE("\t\tBOTON %u PRESIONADO - %lu us", (unsigned int)button, (cycles - press_cycles_[button]) / cycles_per_us);
+      break;
+    default:
+      break;
   }
-  return ret;
+  button_gesture_input(button, event);
 }
 
 /********************** external functions definition ************************/
 
-void task_button(void* argument)
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  button_scan_edge_from_isr(GPIO_Pin);
+}
+
+void task_button_init(void)
 {
-  button_init_();
+  button_gesture_init(button_gesture_);
+  button_scan_init(button_event_);
 
-  while(true)
+  for(size_t i = 0; i < (sizeof(button_pin_) / sizeof(button_pin_[0])); i++)
   {
-    GPIO_PinState button_state;
-    button_state = HAL_GPIO_ReadPin(BUTTON_PORT, BUTTON_PIN);
-
-    button_type_t button_type = BUTTON_TYPE_NONE;
-    button_type = button_process_state_(!button_state);
-
-    switch (button_type) {
-      case BUTTON_TYPE_NONE:
-        break;
-      case BUTTON_TYPE_PULSE:
-        LOGGER_INFO("button pulse");
-        ao_ui_send_event(MSG_EVENT_BUTTON_PULSE);
-        break;
-      case BUTTON_TYPE_SHORT:
-        LOGGER_INFO("button short");
-        ao_ui_send_event(MSG_EVENT_BUTTON_SHORT);
-        break;
-      case BUTTON_TYPE_LONG:
-        LOGGER_INFO("button long");
-        ao_ui_send_event(MSG_EVENT_BUTTON_LONG);
-        break;
-      default:
-        LOGGER_INFO("button error");
-        break;
+    // el reconocedor de gestos tiene menos lugares que el scanner
+    if(BUTTON_GESTURE_BUTTONS_MAX <= button_scan_add(button_port_[i], button_pin_[i], BUTTON_PRESSED))
+    {
+      crash_log_panic("task_button_init BUTTON_GESTURE_BUTTONS_MAX");
     }
 
-    vTaskDelay((TickType_t)(TASK_PERIOD_MS_ / portTICK_PERIOD_MS));
+    GPIO_InitTypeDef init = {0};
+    init.Pin = button_pin_[i];
+    init.Mode = GPIO_MODE_IT_RISING_FALLING;
+    init.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(button_port_[i], &init);
   }
+  button_scan_start();
+
+  HAL_NVIC_SetPriority(BUTTON_EXTI_IRQn, BUTTON_IRQ_PRIORITY_, 0);
+  HAL_NVIC_EnableIRQ(BUTTON_EXTI_IRQn);
 }
 
 /********************** end of file ******************************************/
@@ -34,6 +34,8 @@
 
 /********************** inclusions *******************************************/
 
+#define LOGGER_MODULE_LEVEL       (LOGGER_LEVEL_DEBUG)
+
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -44,25 +46,62 @@
 #include "board.h"
 #include "logger.h"
 #include "dwt.h"
+#include "crash_log.h"
+#include "atomic_ops.h"
+#include "journal.h"
+#include "ao.h"
+#include "led_pwm.h"
+#include "timers.h"
 
 /********************** macros and definitions *******************************/
 
 #define TASK_PERIOD_MS_           (1000)
 
 #define QUEUE_LENGTH_            (10)
-#define QUEUE_ITEM_SIZE_         (sizeof(ao_led_message_t))
+#define TASK_STACK_SIZE_         (128)
+#define TIMER_COMMAND_MS_         (20)   // espera maxima por lugar en la cola de la tarea de timers
 
 /********************** internal data declaration ****************************/
 
+typedef enum
+{
+  LED_EVENT_MESSAGE,
+  LED_EVENT_TIMER,
+  LED_EVENT_RETRY,              // quedan comandos de timer sin entrar en la cola
+} led_event_type_t;
+
+typedef struct
+{
+    uint8_t type;                 // led_event_type_t
+    uint8_t color;                // LED_EVENT_TIMER, ao_led_color
+    uint32_t generation;          // LED_EVENT_TIMER, efecto que armo el timer
+    ao_led_message_t* msg;        // LED_EVENT_MESSAGE
+} led_event_t;
+
+typedef struct
+{
+    ao_led_action_t action;       // AO_LED_MESSAGE__N: sin efecto
+    uint32_t generation;
+    TickType_t period;
+    uint32_t remaining;           // transiciones pendientes, 0: sin fin
+    bool pending;                 // el ultimo comando al timer no entro en la cola
+    volatile bool step_lost;      // vencio con el mailbox lleno y no se pudo rearmar
+    volatile uint32_t step_generation;
+    TimerHandle_t htimer;
+    StaticTimer_t timer_buffer;
+} effect_t;
+
 /********************** internal functions declaration ***********************/
 
 /********************** internal data definition *****************************/
 
 static GPIO_TypeDef* led_port_[] = {LED_RED_PORT, LED_GREEN_PORT,  LED_BLUE_PORT};
 static uint16_t led_pin_[] = {LED_RED_PIN,  LED_GREEN_PIN, LED_BLUE_PIN };
-static bool task_led_running = false; // sólo 1 hilo para manejar los leds
-static QueueHandle_t hqueue;
-static SemaphoreHandle_t led_mutex = NULL;
+AO_DEFINE(ao_led_, "task_ao_led", led_event_t, QUEUE_LENGTH_, TASK_STACK_SIZE_);
+static effect_t effect_[AO_LED_COLOR__N];
+static bool pwm_ = false;  // el pin de LED_PWM_PIN tiene PWM
+static uint8_t led_state_ = 0; // bit n: led ao_led_color n encendido
+static volatile uint32_t timer_failed_ = 0;
 
 /********************** external data definition *****************************/
 
@@ -80,87 +119,381 @@ static const char* ledColorToStr(ao_led_color color)
 	return "INVALIDO";
 }
 
-static void task_(void *argument)
+static void led_state_write_(uint8_t state)
+{
+  if(state != led_state_)
+  {
+    led_state_ = state;
+    journal_append(JOURNAL_EVENT_LED, led_state_);
+  }
+}
+
+static void led_state_set_(ao_led_color color, bool on)
+{
+  led_state_write_(on ? (led_state_ | (1u << color)) : (led_state_ & ~(1u << color)));
+}
+
+static bool pwm_color_(ao_led_color color)
+{
+#if defined(LED_PWM_PIN)
+  return pwm_ && (LED_PWM_PORT == led_port_[color]) && (LED_PWM_PIN == led_pin_[color]);
+#else
+  (void)color;
+  return false;
+#endif
+}
+
+static uint8_t level_(int value)
+{
+  return (value < 0) ? 0 : ((LED_PWM_LEVEL_MAX < value) ? LED_PWM_LEVEL_MAX : (uint8_t)value);
+}
+
+// todos los leds de un puerto cambian juntos, una sola escritura a BSRR por puerto
+static void scene_apply_(uint8_t state)
+{
+  GPIO_TypeDef* port[AO_LED_COLOR__N];
+  uint32_t bsrr[AO_LED_COLOR__N];
+  size_t nports = 0;
+
+  for(size_t color = 0; color < AO_LED_COLOR__N; color++)
+  {
+    size_t i = 0;
+    while((i < nports) && (port[i] != led_port_[color]))
+    {
+      i++;
+    }
+    if(i == nports)
+    {
+      port[nports] = led_port_[color];
+      bsrr[nports] = 0;
+      nports++;
+    }
+    // si dos colores comparten pin, el set de BSRR tiene prioridad sobre el reset
+    bsrr[i] |= (state & (1u << color)) ? (uint32_t)led_pin_[color] : ((uint32_t)led_pin_[color] << 16);
+  }
+
+  led_pwm_detach();
+  for(size_t i = 0; i < nports; i++)
+  {
+    port[i]->BSRR = bsrr[i];
+  }
+  led_state_write_(state);
+}
+
+static void led_write_(ao_led_color color, bool on)
+{
+  if(pwm_color_(color))
+  {
+    led_pwm_detach();
+  }
+  HAL_GPIO_WritePin(led_port_[color], led_pin_[color], on ? GPIO_PIN_SET : GPIO_PIN_RESET);
+  LOGGER_DEBUG("				LED %s %s", ledColorToStr(color), on ? "ENCENDIDO" : "APAGADO");
+  led_state_set_(color, on);
+}
+
+// corre en la tarea de timers: solo avisa al ao, nunca toca los leds
+static void timer_callback_(TimerHandle_t htimer)
+{
+  ao_led_color color = (ao_led_color)(uintptr_t)pvTimerGetTimerID(htimer);
+  led_event_t event = {
+    .type = LED_EVENT_TIMER,
+    .color = (uint8_t)color,
+    .generation = effect_[color].generation,
+  };
+  if(!ao_post(&ao_led_, &event))
+  {
+    // mailbox lleno, reintenta en el proximo tick; la tarea de timers no puede esperar su propia cola
+    if(pdPASS != xTimerChangePeriod(htimer, 1, 0))
+    {
+      // tampoco hay lugar: el mailbox esta lleno, el ao da el paso en su proximo despacho
+      effect_[color].step_generation = event.generation;
+      effect_[color].step_lost = true;
+      atomic_ops_add_u32(&timer_failed_, 1);
+    }
+  }
+}
+
+/*
+ * La cola de comandos de timers la comparten los leds, el scanner y los
+ * gestos; si esta llena se espera un poco a que la tarea de timers (mas
+ * prioritaria) la vacie. Si igual no entra, el efecto queda pendiente y el
+ * comando que corresponda a su estado se reintenta en cada despacho.
+ */
+static void timer_command_(effect_t* peffect)
+{
+  BaseType_t status;
+  if(AO_LED_MESSAGE__N == peffect->action)
+  {
+    status = xTimerStop(peffect->htimer, pdMS_TO_TICKS(TIMER_COMMAND_MS_));
+  }
+  else
+  {
+    status = xTimerChangePeriod(peffect->htimer, peffect->period, pdMS_TO_TICKS(TIMER_COMMAND_MS_));
+  }
+  peffect->pending = (pdPASS != status);
+  if(peffect->pending)
+  {
+    atomic_ops_add_u32(&timer_failed_, 1);
+  }
+}
+
+// detiene el efecto del led; un evento del timer ya encolado queda descartado
+static void effect_stop_(ao_led_color color)
+{
+  effect_t* peffect = &effect_[color];
+  if(AO_LED_MESSAGE__N != peffect->action)
+  {
+    peffect->action = AO_LED_MESSAGE__N;
+    timer_command_(peffect);
+  }
+  peffect->generation++;
+}
+
+static void effect_start_(ao_led_color color, ao_led_action_t action, int ms, uint32_t transitions)
+{
+  effect_t* peffect = &effect_[color];
+  effect_stop_(color);
+  peffect->action = action;
+  peffect->period = pdMS_TO_TICKS(ms);
+  if(0 == peffect->period)
+  {
+    peffect->period = 1;
+  }
+  peffect->remaining = transitions;
+  timer_command_(peffect);
+}
+
+static void effect_step_(ao_led_color color, uint32_t generation)
 {
-  (void)argument;
-  while (true)
+  effect_t* peffect = &effect_[color];
+  if((generation != peffect->generation) || (AO_LED_MESSAGE__N == peffect->action))
   {
-    ao_led_message_t* msg;
-    if (xSemaphoreTake(led_mutex, portMAX_DELAY) == pdTRUE) {} //  tomo el mutex
-    if (pdPASS == xQueueReceive(hqueue, (void*)&msg, 0))
+    return; // efecto reemplazado
+  }
+
+  if(AO_LED_MESSAGE_PULSES == peffect->action)
+  {
+    led_write_(color, 0 == (led_state_ & (1u << color)));
+    if((0 == peffect->remaining) || (0 < --peffect->remaining))
     {
-      xSemaphoreGive(led_mutex);
-      switch (msg->action) {
-        case AO_LED_MESSAGE_ON:
-          HAL_GPIO_WritePin(led_port_[msg->color], led_pin_[msg->color], GPIO_PIN_SET);
-          LOGGER_INFO("				LED %s ENCENDIDO", ledColorToStr(msg->color));
-          msg->callback((void*)msg);
-          break;
-
-        case AO_LED_MESSAGE_OFF:
-          HAL_GPIO_WritePin(led_port_[msg->color], led_pin_[msg->color], GPIO_PIN_RESET);
-          LOGGER_INFO("				LED %s APAGADO", ledColorToStr(msg->color));
-          msg->callback((void*)msg);
-          break;
-
-        case AO_LED_MESSAGE_BLINK:
-          HAL_GPIO_WritePin(led_port_[msg->color], led_pin_[msg->color], GPIO_PIN_SET);
-          LOGGER_INFO("				LED %s ENCENDIDO", ledColorToStr(msg->color));
-          vTaskDelay((TickType_t)((msg->value) / portTICK_PERIOD_MS));
-          HAL_GPIO_WritePin(led_port_[msg->color], led_pin_[msg->color], GPIO_PIN_RESET);
-          LOGGER_INFO("				LED %s APAGADO", ledColorToStr(msg->color));
-          msg->callback((void*)msg);
-          break;
-
-        default:
-          break;
+      timer_command_(peffect);
+      return;
+    }
+  }
+  else
+  {
+    led_write_(color, false);
+  }
+  peffect->action = AO_LED_MESSAGE__N;
+}
+
+static void message_(ao_led_message_t* msg)
+{
+  if (msg->cancelled) {
+    LOGGER_DEBUG("				LED %s comando %d cancelado", ledColorToStr(msg->color), msg->id);
+    msg->callback((void*)msg);
+    return;
+  }
+
+  switch (msg->action) {
+    case AO_LED_MESSAGE_ON:
+      effect_stop_(msg->color);
+      led_write_(msg->color, true);
+      break;
+
+    case AO_LED_MESSAGE_OFF:
+      effect_stop_(msg->color);
+      led_write_(msg->color, false);
+      break;
+
+    case AO_LED_MESSAGE_BLINK:
+      led_write_(msg->color, true);
+      effect_start_(msg->color, AO_LED_MESSAGE_BLINK, msg->value, 1);
+      break;
+
+    case AO_LED_MESSAGE_PULSES:
+      // cada pulso son dos transiciones, la primera (encender) es ahora
+      led_write_(msg->color, true);
+      effect_start_(msg->color, AO_LED_MESSAGE_PULSES, msg->value, (0 < msg->count) ? (2u * (uint32_t)msg->count - 1u) : 0);
+      break;
+
+    case AO_LED_MESSAGE_TIMED_OFF:
+      effect_start_(msg->color, AO_LED_MESSAGE_TIMED_OFF, msg->value, 1);
+      break;
+
+    case AO_LED_MESSAGE_BRIGHTNESS:
+      effect_stop_(msg->color);
+      if(pwm_color_(msg->color))
+      {
+        led_pwm_ramp(level_(msg->value), (uint32_t)msg->ramp_ms);
+        LOGGER_DEBUG("				LED %s brillo %d en %d ms", ledColorToStr(msg->color), msg->value, msg->ramp_ms);
+        led_state_set_(msg->color, 0 < msg->value);
+      }
+      else
+      {
+        led_write_(msg->color, 0 < msg->value);
+      }
+      break;
+
+    case AO_LED_MESSAGE_BREATHE:
+      effect_stop_(msg->color);
+      if(pwm_color_(msg->color))
+      {
+        led_pwm_breathe(level_(msg->value), (uint32_t)msg->ramp_ms);
+        LOGGER_DEBUG("				LED %s respira, periodo %d ms", ledColorToStr(msg->color), msg->ramp_ms);
+        led_state_set_(msg->color, true);
       }
-    }else{
-    	task_led_running = false;
-    	xSemaphoreGive(led_mutex); // Libero el mutex antes de eliminar la tarea
-    	vTaskDelete(NULL);
+      else
+      {
+        led_write_(msg->color, true);
+        effect_start_(msg->color, AO_LED_MESSAGE_PULSES, msg->ramp_ms / 2, 0);
+      }
+      break;
+
+    case AO_LED_MESSAGE_SCENE:
+      for(size_t color = 0; color < AO_LED_COLOR__N; color++)
+      {
+        effect_stop_((ao_led_color)color);
+      }
+      scene_apply_((uint8_t)msg->value);
+      LOGGER_DEBUG("				LEDS escena 0x%02x", (unsigned int)msg->value);
+      break;
+
+    default:
+      break;
+  }
+  msg->callback((void*)msg);
+}
+
+// pasos perdidos y comandos que no entraron en la cola de timers, en orden de llegada
+static void timer_retry_(void)
+{
+  for(size_t color = 0; color < AO_LED_COLOR__N; color++)
+  {
+    effect_t* peffect = &effect_[color];
+    taskENTER_CRITICAL();
+    bool lost = peffect->step_lost;
+    uint32_t generation = peffect->step_generation;
+    peffect->step_lost = false;
+    taskEXIT_CRITICAL();
+
+    if(lost)
+    {
+      effect_step_((ao_led_color)color, generation);
+    }
+    if(peffect->pending)
+    {
+      timer_command_(peffect);
     }
-    vTaskDelay((TickType_t)(50 / portTICK_PERIOD_MS)); // Si no, la button_task se bloquea hasta que se termine de procesar la accion
   }
 }
 
-BaseType_t ao_led_create_task(){
-  return xTaskCreate(task_, "task_ao_led", 128, NULL, tskIDLE_PRIORITY, NULL);
+// si algo quedo pendiente el ao se despierta solo; con el mailbox lleno ya hay otro despacho en camino
+static void timer_retry_post_(void)
+{
+  for(size_t color = 0; color < AO_LED_COLOR__N; color++)
+  {
+    if(effect_[color].pending || effect_[color].step_lost)
+    {
+      led_event_t event = {
+        .type = LED_EVENT_RETRY,
+      };
+      (void)ao_post(&ao_led_, &event);
+      return;
+    }
+  }
+}
+
+static void dispatch_(ao_t* hao, const void* pevent)
+{
+  (void)hao;
+  const led_event_t* pled_event = (const led_event_t*)pevent;
+  timer_retry_();
+  switch (pled_event->type) {
+    case LED_EVENT_MESSAGE:
+      message_(pled_event->msg);
+      break;
+
+    case LED_EVENT_TIMER:
+      effect_step_((ao_led_color)pled_event->color, pled_event->generation);
+      break;
+
+    default:
+      break;
+  }
+  timer_retry_post_();
+}
+
+#if 1 == AO_LED_CONFIG_RESTART_TEST
+// ao_stop descarta los eventos pendientes: cada mensaje devuelve su referencia con el callback
+static void drop_(ao_t* hao, const void* pevent)
+{
+  (void)hao;
+  const led_event_t* pled_event = (const led_event_t*)pevent;
+  if(LED_EVENT_MESSAGE == pled_event->type)
+  {
+    pled_event->msg->callback((void*)pled_event->msg);
+  }
 }
+#endif
 
 /********************** external functions definition ************************/
 
 bool ao_led_send(ao_led_message_t* msg)
 {
-	if (xSemaphoreTake(led_mutex, portMAX_DELAY) == pdTRUE) {
-		if(!task_led_running) {
-			if(ao_led_create_task() != pdPASS) {
-				LOGGER_INFO("ERROR CREANDO TAREA LEDS!");
-			}else {
-				// LOGGER_INFO("Tarea Leds creada");
-				task_led_running = true;
-			}
-		}
-		xSemaphoreGive(led_mutex);
-	}
-
-	return (xQueueSend(hqueue,(void*)&msg,0) == pdPASS);
+  led_event_t event = {
+    .type = LED_EVENT_MESSAGE,
+    .msg = msg,
+  };
+  return ao_post(&ao_led_, &event);
 }
 
 void ao_led_init()
 {
-  hqueue = xQueueCreate(QUEUE_LENGTH_, QUEUE_ITEM_SIZE_);
-  if(NULL == hqueue){
-	  LOGGER_INFO("ERROR: ao_led_init xQueueCreate");
-	  while (true){/*ERROR*/}
+  pwm_ = led_pwm_init();
+
+  for(size_t color = 0; color < AO_LED_COLOR__N; color++)
+  {
+    effect_[color].action = AO_LED_MESSAGE__N;
+    effect_[color].htimer = xTimerCreateStatic("led", 1, pdFALSE, (void*)(uintptr_t)color, timer_callback_, &effect_[color].timer_buffer);
+    if(NULL == effect_[color].htimer)
+    {
+      crash_log_panic("ao_led_init xTimerCreateStatic");
+    }
   }
 
-  led_mutex = xSemaphoreCreateMutex();
-  if (NULL == led_mutex) {
-	  LOGGER_INFO("ERROR: ao_led_init xSemaphoreCreateMutex");
-	  while (true) {};
+  ao_start(&ao_led_, dispatch_, tskIDLE_PRIORITY, NULL);
+
+  ao_stats_t stats;
+  ao_stats(&ao_led_, &stats);
+  LOGGER_INFO("ao_led: tarea creada en %lu ciclos", stats.start_cycles);
+}
+
+#if 1 == AO_LED_CONFIG_RESTART_TEST
+void ao_led_restart(void)
+{
+  // a mitad de un despacho el ao tiene un mensaje en la mano: se espera a que termine
+  while(!ao_stop(&ao_led_, drop_))
+  {
+    vTaskDelay(1);
+  }
+  // con la tarea borrada nadie mas toca los efectos; los timers pendientes quedan sin efecto
+  for(size_t color = 0; color < AO_LED_COLOR__N; color++)
+  {
+    effect_stop_((ao_led_color)color);
   }
+  ao_start(&ao_led_, dispatch_, tskIDLE_PRIORITY, NULL);
+  timer_retry_post_();
+
+  ao_stats_t stats;
+  ao_stats(&ao_led_, &stats);
+  LOGGER_INFO("ao_led: reinicio, stop %lu ciclos, start %lu ciclos", stats.stop_cycles, stats.start_cycles);
+}
+#endif
 
+uint32_t ao_led_timer_failed(void)
+{
+  return timer_failed_;
 }
 
 /********************** end of file ******************************************/
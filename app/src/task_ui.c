@@ -47,34 +47,41 @@
 #include "board.h"
 #include "logger.h"
 #include "dwt.h"
+#include "crash_log.h"
+#include "journal.h"
 
 #include "task_ui.h"
 #include "task_led.h"
 #include "memory_pool.h"
+#include "id_index.h"
+#include "ao.h"
 
 /********************** macros and definitions *******************************/
 
-#define QUEUE_LENGTH_            (1)
-#define QUEUE_ITEM_SIZE_         (sizeof(msg_event_t))
+#define QUEUE_LENGTH_            (8)    // un click seguido de hold encola CLICK y SHORT juntos, y la tarea puede esperar al pool
+#define TASK_STACK_SIZE_         (128)
 
 #define MEMORY_POOL_NBLOCKS       (10)
-#define MEMORY_POOL_BLOCK_SIZE    (sizeof(ao_led_message_t))
+#define MEMORY_POOL_TIMEOUT_MS    (200)
+#define INFLIGHT_CAPACITY_        (16)   // potencia de 2, > MEMORY_POOL_NBLOCKS
 
 /********************** internal data declaration ****************************/
 
-typedef struct
-{
-    QueueHandle_t hqueue;
-} ao_ui_handle_t;
-
 /********************** internal functions declaration ***********************/
 
 /********************** internal data definition *****************************/
 
-static ao_ui_handle_t hao_;
+AO_DEFINE(ao_ui_, "task_ao_ui", msg_event_t, QUEUE_LENGTH_, TASK_STACK_SIZE_);
+static const msg_event_t init_event_ = MSG_EVENT_INIT;
 static int msg_wip_ = 0;
-static memory_pool_t memory_pool_;
-static uint8_t memory_pool_memory_[MEMORY_POOL_SIZE(MEMORY_POOL_NBLOCKS, MEMORY_POOL_BLOCK_SIZE)];
+MEMORY_POOL_DEFINE(memory_pool_, ao_led_message_t, MEMORY_POOL_NBLOCKS);
+static StaticSemaphore_t memory_pool_sem_;
+ID_INDEX_STORAGE(inflight_storage_, INFLIGHT_CAPACITY_);
+static id_index_t inflight_;               // id -> mensaje publicado y no confirmado
+static int last_id_[AO_LED_COLOR__N];
+static bool last_id_valid_[AO_LED_COLOR__N];
+static int last_scene_id_;
+static bool last_scene_id_valid_;
 
 /********************** external data definition *****************************/
 
@@ -84,9 +91,31 @@ memory_pool_t* const hmp = &memory_pool_;
 
 /********************** internal functions definition ************************/
 
+// el indice se comparte con el callback, que corre en la tarea de leds
+static void inflight_remove_(int id)
+{
+	taskENTER_CRITICAL();
+	id_index_remove(&inflight_, (uint32_t)id);
+	taskEXIT_CRITICAL();
+}
+
+// marca como cancelado un mensaje aun no procesado, O(1)
+static void inflight_cancel_(int id)
+{
+	taskENTER_CRITICAL();
+	ao_led_message_t* led_msg = (ao_led_message_t*)id_index_find(&inflight_, (uint32_t)id);
+	if(NULL != led_msg)
+	{
+		led_msg->cancelled = true;
+	}
+	taskEXIT_CRITICAL();
+}
+
+// cada consumidor libera su referencia, el ultimo devuelve el bloque al pool
 static void callback_(void* ptr)
 {
-	memory_pool_block_put(hmp, (void*)ptr);
+	inflight_remove_(((ao_led_message_t*)ptr)->id);
+	memory_pool_block_release(hmp, (void*)ptr);
     // LOGGER_INFO("Memoria liberada desde button");
     // LOGGER_INFO("Mensajes en proceso: %d", --msg_wip_);
 }
@@ -94,61 +123,119 @@ static void callback_(void* ptr)
 static void sendmsg(ao_led_color color ,ao_led_action_t action, int value)
 {
 	static int id = 0;
-	ao_led_message_t* led_msg = (ao_led_message_t*)memory_pool_block_get(hmp);
+	// espera a que se libere un bloque en lugar de perder el mensaje
+	ao_led_message_t* led_msg = (ao_led_message_t*)memory_pool_block_get_timeout(hmp, (TickType_t)(MEMORY_POOL_TIMEOUT_MS / portTICK_PERIOD_MS));
 	if(NULL != led_msg)
 	{
 	  led_msg->callback = callback_;
 	  led_msg->id = id++;
 	  led_msg->action = action;
 	  led_msg->value = value;
+	  led_msg->count = 0;
+	  led_msg->ramp_ms = 0;
 	  led_msg->color = color;
-	  vTaskDelay((TickType_t)(50 / portTICK_PERIOD_MS)); // Si no, la button_task se bloquea hasta que se termine de procesar la accion
+	  led_msg->cancelled = false;
+
+	  // el comando nuevo reemplaza al pendiente del mismo led, una escena a todos
+	  if(AO_LED_MESSAGE_SCENE == action)
+	  {
+		  for(size_t c = 0; c < AO_LED_COLOR__N; c++)
+		  {
+			  if(last_id_valid_[c])
+			  {
+				  inflight_cancel_(last_id_[c]);
+				  last_id_valid_[c] = false;
+			  }
+		  }
+		  if(last_scene_id_valid_)
+		  {
+			  inflight_cancel_(last_scene_id_);
+		  }
+		  last_scene_id_ = led_msg->id;
+		  last_scene_id_valid_ = true;
+	  }
+	  else
+	  {
+		  if(last_id_valid_[color])
+		  {
+			  inflight_cancel_(last_id_[color]);
+		  }
+		  last_id_[color] = led_msg->id;
+		  last_id_valid_[color] = true;
+	  }
+	  taskENTER_CRITICAL();
+	  bool indexed = id_index_insert(&inflight_, (uint32_t)led_msg->id, led_msg);
+	  taskEXIT_CRITICAL();
+	  if(!indexed)
+	  {
+		  // se envia igual, solo que ya no se puede cancelar
+		  LOGGER_WARN("sendmsg: indice de mensajes lleno, id %d sin cancelacion", led_msg->id);
+	  }
+
+	  // una referencia por consumidor, tomada antes de publicar el mensaje
+	  memory_pool_block_ref(led_msg);
 	  if(ao_led_send(led_msg) == false)
 	  {
-		  memory_pool_block_put(hmp, (void*)led_msg);
+		  inflight_remove_(led_msg->id);
+		  memory_pool_block_release(hmp, (void*)led_msg);
+	  }
+	  else
+	  {
+		  msg_wip_++;
 	  }
-	  msg_wip_++;
+	  memory_pool_block_release(hmp, (void*)led_msg);
+	}
+	else
+	{
+	  memory_pool_stats_t stats;
+	  memory_pool_stats(hmp, &stats);
+	  LOGGER_WARN("sendmsg: timeout memory pool, %lu fallos, maximo %lu/%lu", stats.failed, stats.high_water, stats.nblocks);
 	}
 }
 
-static void task_(void *argument)
+static void dispatch_(ao_t* hao, const void* pevent)
 {
-  memory_pool_init(hmp, memory_pool_memory_, MEMORY_POOL_NBLOCKS, MEMORY_POOL_BLOCK_SIZE);
-
-  sendmsg(AO_LED_COLOR_RED   , AO_LED_MESSAGE_OFF, 0);
-  sendmsg(AO_LED_COLOR_GREEN , AO_LED_MESSAGE_OFF, 0);
-  sendmsg(AO_LED_COLOR_BLUE  , AO_LED_MESSAGE_OFF, 0);
-
-  msg_event_t event_msg = {0};
-
-  while (true)
+  (void)hao;
+  switch (*(const msg_event_t*)pevent)
   {
-    if (pdPASS == xQueueReceive(hao_.hqueue, &event_msg, portMAX_DELAY))
+    case MSG_EVENT_INIT:
     {
-      switch (event_msg)
-      {
-        case MSG_EVENT_BUTTON_PULSE:
-          LOGGER_INFO("led red");
-          sendmsg(AO_LED_COLOR_BLUE  , AO_LED_MESSAGE_OFF, 0);
-          sendmsg(AO_LED_COLOR_GREEN , AO_LED_MESSAGE_OFF, 0);
-          sendmsg(AO_LED_COLOR_RED   , AO_LED_MESSAGE_ON , 0);
-          break;
-        case MSG_EVENT_BUTTON_SHORT:
-          LOGGER_INFO("led green");
-          sendmsg(AO_LED_COLOR_BLUE  , AO_LED_MESSAGE_OFF, 0);
-          sendmsg(AO_LED_COLOR_RED   , AO_LED_MESSAGE_OFF, 0);
-          sendmsg(AO_LED_COLOR_GREEN , AO_LED_MESSAGE_ON , 0);
-          break;
-        case MSG_EVENT_BUTTON_LONG:
-          LOGGER_INFO("led blue");
-          sendmsg(AO_LED_COLOR_RED   , AO_LED_MESSAGE_OFF, 0);
-          sendmsg(AO_LED_COLOR_GREEN , AO_LED_MESSAGE_OFF, 0);
-          sendmsg(AO_LED_COLOR_BLUE  , AO_LED_MESSAGE_ON , 0);
-          break;
-        default:
-          break;
-      }
+      // sin magazine: esta tarea solo pide bloques, los devuelve la tarea de leds
+      memory_pool_blocking_init(hmp, &memory_pool_sem_);
+
+#if 1 == AO_LED_CONFIG_RESTART_TEST
+      // diagnostico: mide lo que cuesta parar y rearrancar un ao (se loguea)
+      ao_led_restart();
+#endif
+
+      // restaura el estado de los leds guardado en el journal
+      uint8_t led_state = 0;
+      journal_last(JOURNAL_EVENT_LED, &led_state);
+      sendmsg(AO_LED_COLOR_RED, AO_LED_MESSAGE_SCENE, led_state);
+      break;
     }
+    case MSG_EVENT_BUTTON_PULSE:
+      LOGGER_INFO("led red");
+      sendmsg(AO_LED_COLOR_RED, AO_LED_MESSAGE_SCENE, (1u << AO_LED_COLOR_RED));
+      break;
+    case MSG_EVENT_BUTTON_SHORT:
+      LOGGER_INFO("led green");
+      sendmsg(AO_LED_COLOR_GREEN, AO_LED_MESSAGE_SCENE, (1u << AO_LED_COLOR_GREEN));
+      break;
+    case MSG_EVENT_BUTTON_LONG:
+      LOGGER_INFO("led blue");
+      sendmsg(AO_LED_COLOR_BLUE, AO_LED_MESSAGE_SCENE, (1u << AO_LED_COLOR_BLUE));
+      break;
+    case MSG_EVENT_BUTTON_DOUBLE:
+      LOGGER_INFO("leds on");
+      sendmsg(AO_LED_COLOR_RED, AO_LED_MESSAGE_SCENE, (1u << AO_LED_COLOR__N) - 1u);
+      break;
+    case MSG_EVENT_BUTTON_TRIPLE:
+      LOGGER_INFO("leds off");
+      sendmsg(AO_LED_COLOR_RED, AO_LED_MESSAGE_SCENE, 0);
+      break;
+    default:
+      break;
   }
 }
 
@@ -156,23 +243,16 @@ static void task_(void *argument)
 
 bool ao_ui_send_event(msg_event_t msg)
 {
-  return (pdPASS == xQueueSend(hao_.hqueue, (void*)&msg, 0));
+  return ao_post(&ao_ui_, &msg);
 }
 
 void ao_ui_init(void)
 {
-  hao_.hqueue = xQueueCreate(QUEUE_LENGTH_, QUEUE_ITEM_SIZE_);
-  while(NULL == hao_.hqueue)
-  {
-    // error
-  }
-
-  BaseType_t status;
-  status = xTaskCreate(task_, "task_ao_ui", 128, NULL, tskIDLE_PRIORITY, NULL);
-  while (pdPASS != status)
+  if(!id_index_init(&inflight_, inflight_storage_, INFLIGHT_CAPACITY_))
   {
-    // error
+    crash_log_panic("ao_ui_init id_index_init");
   }
+  ao_start(&ao_ui_, dispatch_, tskIDLE_PRIORITY, &init_event_);
 }
 
 /********************** end of file ******************************************/
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : uart_tx.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "uart_tx.h"
+
+/********************** macros and definitions *******************************/
+
+#define BUFFER_MASK_              (UART_TX_CONFIG_BUFFER_SIZE - 1)
+
+#if 0 != (UART_TX_CONFIG_BUFFER_SIZE & BUFFER_MASK_)
+#error "UART_TX_CONFIG_BUFFER_SIZE must be a power of two"
+#endif
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/*
+ * TX ring: producers reserve [head, reserve) and copy into it with the
+ * interrupts enabled; when the last of them is done head catches up with
+ * reserve and the bytes become visible to the DMA, which owns
+ * [tail, tail + inflight). While one chunk is on the wire the next one is
+ * being filled; a chunk that crosses the end of the buffer goes out as two
+ * back to back transfers.
+ */
+static struct
+{
+    UART_HandleTypeDef* huart;
+    volatile uint32_t head;
+    volatile uint32_t reserve;
+    volatile uint32_t writers;
+    volatile uint32_t tail;
+    volatile uint32_t inflight;
+    volatile uint32_t dropped;
+    uint8_t buffer[UART_TX_CONFIG_BUFFER_SIZE];
+} uart_tx_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/* must be called with the UART and DMA interrupts masked */
+static void start_tx_(void)
+{
+  if(0 != uart_tx_.inflight)
+  {
+    return;
+  }
+
+  uint32_t pending = uart_tx_.head - uart_tx_.tail;
+  if(0 == pending)
+  {
+    return;
+  }
+
+  uint32_t offset = uart_tx_.tail & BUFFER_MASK_;
+  uint32_t len = UART_TX_CONFIG_BUFFER_SIZE - offset;
+  if(pending < len)
+  {
+    len = pending;
+  }
+
+  if(HAL_OK == HAL_UART_Transmit_DMA(uart_tx_.huart, &uart_tx_.buffer[offset], (uint16_t)len))
+  {
+    uart_tx_.inflight = len;
+  }
+}
+
+static void end_tx_(void)
+{
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+  uart_tx_.tail += uart_tx_.inflight;
+  uart_tx_.inflight = 0;
+  start_tx_();
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+/********************** external functions definition ************************/
+
+void uart_tx_init(UART_HandleTypeDef* huart)
+{
+  uart_tx_.head = 0;
+  uart_tx_.reserve = 0;
+  uart_tx_.writers = 0;
+  uart_tx_.tail = 0;
+  uart_tx_.inflight = 0;
+  uart_tx_.dropped = 0;
+  uart_tx_.huart = huart;
+}
+
+/*
+ * Never blocks: copies as much as fits in the ring, starts the DMA if it is
+ * idle and returns. Bytes that do not fit are dropped and counted.
+ * Safe from tasks and from ISRs up to configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ * Interrupts are only masked to reserve the range and to publish it, the
+ * copy itself runs unmasked.
+ */
+size_t uart_tx_write(const void* data, size_t len)
+{
+  if(NULL == uart_tx_.huart)
+  {
+    return 0;
+  }
+
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+  uint32_t free = UART_TX_CONFIG_BUFFER_SIZE - (uart_tx_.reserve - uart_tx_.tail);
+  size_t n = (len <= free) ? len : free;
+  uart_tx_.dropped += len - n;
+  uint32_t offset = uart_tx_.reserve & BUFFER_MASK_;
+  uart_tx_.reserve += n;
+  uart_tx_.writers++;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  size_t first = UART_TX_CONFIG_BUFFER_SIZE - offset;
+  if(n < first)
+  {
+    first = n;
+  }
+  memcpy(&uart_tx_.buffer[offset], data, first);
+  memcpy(&uart_tx_.buffer[0], (const uint8_t*)data + first, n - first);
+
+  /* a writer preempted mid copy holds back the ones that reserved after it */
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if(0 == --uart_tx_.writers)
+  {
+    uart_tx_.head = uart_tx_.reserve;
+    start_tx_();
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+  return n;
+}
+
+uint32_t uart_tx_dropped(void)
+{
+  return uart_tx_.dropped;
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart)
+{
+  if(huart == uart_tx_.huart)
+  {
+    end_tx_();
+  }
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart)
+{
+  if(huart == uart_tx_.huart)
+  {
+    end_tx_(); // the chunk is lost, keep draining
+  }
+}
+
+/* newlib stdout/stderr, overrides the weak _write in Core/Src/syscalls.c */
+int _write(int file, char* ptr, int len)
+{
+  (void)file;
+  uart_tx_write(ptr, (size_t)len);
+  return len;
+}
+
+/********************** end of file ******************************************/
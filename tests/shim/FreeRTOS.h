@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : FreeRTOS.h
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef FREERTOS_H_
+#define FREERTOS_H_
+
+/*
+ * Host stand-in for the FreeRTOS API the app modules use. Every pthread is a
+ * "task" with its own thread local storage; the scheduler is always running.
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+/********************** macros ***********************************************/
+
+#define configASSERT(x)                             assert(x)
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS     (1)
+
+#define pdFALSE                                     ((BaseType_t)0)
+#define pdTRUE                                      ((BaseType_t)1)
+#define pdPASS                                      pdTRUE
+
+#define taskSCHEDULER_NOT_STARTED                   ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING                       ((BaseType_t)2)
+
+#define portYIELD_FROM_ISR(x)                       ((void)(x))
+
+/********************** typedef **********************************************/
+
+typedef long BaseType_t;
+typedef uint32_t TickType_t;
+typedef void* TaskHandle_t;
+
+typedef struct
+{
+  TickType_t entry;
+} TimeOut_t;
+
+/********************** external data declaration ****************************/
+
+extern _Thread_local void* host_tls_[configNUM_THREAD_LOCAL_STORAGE_POINTERS];
+
+/********************** external functions declaration ***********************/
+
+static inline BaseType_t xTaskGetSchedulerState(void)
+{
+  return taskSCHEDULER_RUNNING;
+}
+
+static inline void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t htask, BaseType_t index)
+{
+  (void)htask;
+  return host_tls_[index];
+}
+
+static inline void vTaskSetThreadLocalStoragePointer(TaskHandle_t htask, BaseType_t index, void* pvalue)
+{
+  (void)htask;
+  host_tls_[index] = pvalue;
+}
+
+/* blocking gets are not exercised on the host, a timeout expires at once */
+static inline void vTaskSetTimeOutState(TimeOut_t* ptime_out)
+{
+  ptime_out->entry = 0;
+}
+
+static inline BaseType_t xTaskCheckForTimeOut(TimeOut_t* ptime_out, TickType_t* pticks)
+{
+  (void)ptime_out;
+  *pticks = 0;
+  return pdTRUE;
+}
+
+#endif /* FREERTOS_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : main.h
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef MAIN_H_
+#define MAIN_H_
+
+/*
+ * Host stand-in for the CubeMX main.h: only the CMSIS intrinsics the app
+ * modules use. LDREX/STREX are emulated with one global exclusive monitor,
+ * like the single core target where any exception entry clears it: a STREX
+ * fails if any other STREX succeeded since this thread's LDREX, whatever the
+ * address. That keeps the ABA protection the Treiber stack relies on.
+ *
+ * The modules keep pointers in 32-bit words, as on the target. The tests are
+ * linked without PIE so the static storage they hand out sits below 4 GB.
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/********************** macros ***********************************************/
+
+/********************** typedef **********************************************/
+
+/********************** external data declaration ****************************/
+
+extern _Atomic uint32_t host_monitor_;          /* odd while a STREX stores */
+extern _Thread_local uint32_t host_monitor_seq_;
+extern _Thread_local bool host_monitor_open_;
+
+/********************** external functions declaration ***********************/
+
+static inline uint32_t __LDREXW(volatile uint32_t* addr)
+{
+  uint32_t seq;
+  uint32_t value;
+  do
+  {
+    seq = atomic_load(&host_monitor_);
+    value = atomic_load((_Atomic uint32_t*)addr);
+  } while((0 != (seq & 1u)) || (seq != atomic_load(&host_monitor_)));
+  host_monitor_seq_ = seq;
+  host_monitor_open_ = true;
+  return value;
+}
+
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t* addr)
+{
+  uint32_t seq = host_monitor_seq_;
+  if(!host_monitor_open_)
+  {
+    return 1;
+  }
+  host_monitor_open_ = false;
+  if(!atomic_compare_exchange_strong(&host_monitor_, &seq, seq + 1))
+  {
+    return 1;
+  }
+  atomic_store((_Atomic uint32_t*)addr, value);
+  atomic_store(&host_monitor_, seq + 2);
+  return 0;
+}
+
+static inline void __CLREX(void)
+{
+  host_monitor_open_ = false;
+}
+
+static inline void __DMB(void)
+{
+  atomic_thread_fence(memory_order_seq_cst);
+}
+
+/* always thread mode on the host */
+static inline uint32_t __get_IPSR(void)
+{
+  return 0;
+}
+
+#endif /* MAIN_H_ */
+/********************** end of file ******************************************/
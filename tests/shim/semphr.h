@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : semphr.h
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+#ifndef SEMPHR_H_
+#define SEMPHR_H_
+
+/********************** inclusions *******************************************/
+
+#include "FreeRTOS.h"
+
+/********************** typedef **********************************************/
+
+typedef struct
+{
+  uint32_t count;
+} StaticSemaphore_t;
+
+typedef StaticSemaphore_t* SemaphoreHandle_t;
+
+/********************** external functions declaration ***********************/
+
+/* only the calls are checked on the host, nothing ever waits on them */
+
+static inline SemaphoreHandle_t xSemaphoreCreateCountingStatic(uint32_t max, uint32_t initial, StaticSemaphore_t* psem)
+{
+  (void)max;
+  psem->count = initial;
+  return psem;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t hsem)
+{
+  (void)hsem;
+  return pdPASS;
+}
+
+static inline BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t hsem, BaseType_t* pwoken)
+{
+  (void)hsem;
+  *pwoken = pdFALSE;
+  return pdPASS;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t hsem, TickType_t ticks)
+{
+  (void)hsem;
+  (void)ticks;
+  return pdFALSE;
+}
+
+#endif /* SEMPHR_H_ */
+/********************** end of file ******************************************/
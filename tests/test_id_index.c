@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : test_id_index.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "id_index.h"
+
+/********************** macros and definitions *******************************/
+
+#define CAPACITY_                 (8)
+#define IDS_                      (64)
+#define STEPS_                    (200000)
+
+#define CHECK_(cond) \
+  do \
+  { \
+    if(!(cond)) \
+    { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      exit(EXIT_FAILURE); \
+    } \
+  } while(0)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+ID_INDEX_STORAGE(storage_, CAPACITY_);
+static id_index_t index_;
+
+/* reference model: value of each id, NULL when absent */
+static void* model_[IDS_];
+static uint32_t model_count_;
+static uint8_t value_[IDS_];
+static uint32_t seed_ = 1;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint32_t random_(uint32_t n)
+{
+  seed_ = seed_ * 1103515245u + 12345u;
+  return (seed_ >> 8) % n;
+}
+
+static uint32_t home_(uint32_t id)
+{
+  return (id * 2654435769u) >> index_.shift;
+}
+
+/* first id above from whose home slot is home */
+static uint32_t id_at_home_(uint32_t home, uint32_t from)
+{
+  uint32_t id = from;
+  while(home != home_(id))
+  {
+    id++;
+  }
+  return id;
+}
+
+/*
+ * Every stored entry is reachable: no empty slot between its home and
+ * itself, going forward and wrapping at the end of the table.
+ */
+static void table_check_(void)
+{
+  uint32_t count = 0;
+  for(uint32_t i = 0; i < CAPACITY_; ++i)
+  {
+    const id_index_entry_t* pentry = &storage_[i];
+    if(NULL == pentry->pvalue)
+    {
+      continue;
+    }
+    count++;
+    for(uint32_t j = home_(pentry->id); j != i; j = (j + 1) & (CAPACITY_ - 1))
+    {
+      CHECK_(NULL != storage_[j].pvalue);
+    }
+  }
+  CHECK_(count == id_index_count(&index_));
+}
+
+static void model_check_(void)
+{
+  table_check_();
+  CHECK_(model_count_ == id_index_count(&index_));
+  for(uint32_t id = 0; id < IDS_; ++id)
+  {
+    CHECK_(model_[id] == id_index_find(&index_, id));
+  }
+}
+
+static void insert_(uint32_t id)
+{
+  bool full = (NULL == model_[id]) && ((CAPACITY_ - 1) == model_count_);
+  CHECK_(!full == id_index_insert(&index_, id, &value_[id]));
+  if(!full)
+  {
+    model_count_ += (NULL == model_[id]) ? 1 : 0;
+    model_[id] = &value_[id];
+  }
+}
+
+static void remove_(uint32_t id)
+{
+  CHECK_(model_[id] == id_index_remove(&index_, id));
+  model_count_ -= (NULL == model_[id]) ? 0 : 1;
+  model_[id] = NULL;
+}
+
+/* a cluster whose home is the last slot spills into slots 0 and 1 */
+static void wrap_check_(void)
+{
+  CHECK_(id_index_init(&index_, storage_, CAPACITY_));
+  uint32_t a = id_at_home_(CAPACITY_ - 1, 0);
+  uint32_t b = id_at_home_(CAPACITY_ - 1, a + 1);
+  uint32_t c = id_at_home_(0, 0);
+  uint32_t d = id_at_home_(CAPACITY_ - 1, b + 1);
+  CHECK_(id_index_insert(&index_, a, &value_[0]));
+  CHECK_(id_index_insert(&index_, b, &value_[1]));
+  CHECK_(id_index_insert(&index_, c, &value_[2]));
+  CHECK_(id_index_insert(&index_, d, &value_[3]));
+  CHECK_((a == storage_[CAPACITY_ - 1].id) && (b == storage_[0].id) && (c == storage_[1].id) && (d == storage_[2].id));
+
+  /* b and d shift back across the end of the table, c (home 0) shifts too */
+  CHECK_(&value_[0] == id_index_remove(&index_, a));
+  CHECK_((b == storage_[CAPACITY_ - 1].id) && (c == storage_[0].id) && (d == storage_[1].id));
+  CHECK_(NULL == storage_[2].pvalue);
+  CHECK_(&value_[1] == id_index_find(&index_, b));
+  CHECK_(&value_[2] == id_index_find(&index_, c));
+  CHECK_(&value_[3] == id_index_find(&index_, d));
+
+  /* c sits at its home, removing it must pull d back but not past its home */
+  CHECK_(&value_[2] == id_index_remove(&index_, c));
+  CHECK_((b == storage_[CAPACITY_ - 1].id) && (d == storage_[0].id) && (NULL == storage_[1].pvalue));
+  CHECK_(NULL == id_index_find(&index_, a));
+  CHECK_(NULL == id_index_remove(&index_, a));
+  CHECK_(2 == id_index_count(&index_));
+}
+
+/********************** external functions definition ************************/
+
+int main(void)
+{
+  {
+    id_index_t index;
+    CHECK_(!id_index_init(&index, storage_, 1));
+    CHECK_(!id_index_init(&index, storage_, 6));
+  }
+
+  wrap_check_();
+
+  CHECK_(id_index_init(&index_, storage_, CAPACITY_));
+  for(uint32_t i = 0; i < STEPS_; ++i)
+  {
+    uint32_t id = random_(IDS_);
+    if(0 == random_(2))
+    {
+      insert_(id);
+    }
+    else
+    {
+      remove_(id);
+    }
+    model_check_();
+  }
+  printf("id_index: wrap-around and %u random steps ok\n", STEPS_);
+  return EXIT_SUCCESS;
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : test_linked_list.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "linked_list.h"
+
+/********************** macros and definitions *******************************/
+
+#define ITEMS_                    (32)
+#define STEPS_                    (200000)
+
+#define CHECK_(cond) \
+  do \
+  { \
+    if(!(cond)) \
+    { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      exit(EXIT_FAILURE); \
+    } \
+  } while(0)
+
+/********************** internal data declaration ****************************/
+
+/* the node is not the first member, so CONTAINER_OF has to subtract */
+typedef struct
+{
+  uint32_t id;
+  int list;                 /* -1 when unlisted */
+  linked_list_node_t node;
+} item_t;
+
+/* reference model: the ids of each list, in order */
+typedef struct
+{
+  uint32_t id[ITEMS_];
+  size_t len;
+} model_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+static item_t item_[ITEMS_];
+static linked_list_t list_[2];
+static model_t model_[2];
+static uint32_t seed_ = 1;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint32_t random_(uint32_t n)
+{
+  seed_ = seed_ * 1103515245u + 12345u;
+  return (seed_ >> 8) % n;
+}
+
+static size_t model_find_(const model_t* pmodel, uint32_t id)
+{
+  for(size_t i = 0; i < pmodel->len; ++i)
+  {
+    if(id == pmodel->id[i])
+    {
+      return i;
+    }
+  }
+  CHECK_(false);
+  return 0;
+}
+
+static void model_insert_(model_t* pmodel, size_t pos, uint32_t id)
+{
+  memmove(&pmodel->id[pos + 1], &pmodel->id[pos], (pmodel->len - pos) * sizeof(pmodel->id[0]));
+  pmodel->id[pos] = id;
+  pmodel->len++;
+}
+
+static void model_erase_(model_t* pmodel, size_t pos)
+{
+  pmodel->len--;
+  memmove(&pmodel->id[pos], &pmodel->id[pos + 1], (pmodel->len - pos) * sizeof(pmodel->id[0]));
+}
+
+/* both directions of the list against the model */
+static void list_check_(const linked_list_t* hlist, const model_t* pmodel)
+{
+  CHECK_(pmodel->len == hlist->len);
+  CHECK_((0 == hlist->len) == (NULL == hlist->pfirst_node));
+  CHECK_((0 == hlist->len) == (NULL == hlist->plast_node));
+
+  size_t i = 0;
+  const linked_list_node_t* hprev = NULL;
+  for(const linked_list_node_t* hnode = hlist->pfirst_node; NULL != hnode; hnode = hnode->pnext_node)
+  {
+    CHECK_(i < pmodel->len);
+    CHECK_(hprev == hnode->pprev_node);
+    CHECK_(pmodel->id[i] == LINKED_LIST_CONTAINER_OF(hnode, item_t, node)->id);
+    hprev = hnode;
+    i++;
+  }
+  CHECK_(pmodel->len == i);
+  CHECK_(hprev == hlist->plast_node);
+}
+
+static item_t* unlisted_(void)
+{
+  uint32_t start = random_(ITEMS_);
+  for(uint32_t i = 0; i < ITEMS_; ++i)
+  {
+    item_t* pitem = &item_[(start + i) % ITEMS_];
+    if(-1 == pitem->list)
+    {
+      return pitem;
+    }
+  }
+  return NULL;
+}
+
+static item_t* listed_(int list)
+{
+  if(0 == model_[list].len)
+  {
+    return NULL;
+  }
+  return &item_[model_[list].id[random_((uint32_t)model_[list].len)]];
+}
+
+static void step_(void)
+{
+  int list = (int)random_(2);
+  linked_list_t* hlist = &list_[list];
+  model_t* pmodel = &model_[list];
+  item_t* pitem = unlisted_();
+  item_t* ppos = listed_(list);
+
+  switch (random_(7))
+  {
+    case 0:
+      if(NULL != pitem)
+      {
+        linked_list_node_add(hlist, &pitem->node);
+        model_insert_(pmodel, pmodel->len, pitem->id);
+        pitem->list = list;
+      }
+      break;
+    case 1:
+      if((NULL != pitem) && (NULL != ppos))
+      {
+        linked_list_node_insert_after(hlist, &ppos->node, &pitem->node);
+        model_insert_(pmodel, model_find_(pmodel, ppos->id) + 1, pitem->id);
+        pitem->list = list;
+      }
+      break;
+    case 2:
+      if((NULL != pitem) && (NULL != ppos))
+      {
+        linked_list_node_insert_before(hlist, &ppos->node, &pitem->node);
+        model_insert_(pmodel, model_find_(pmodel, ppos->id), pitem->id);
+        pitem->list = list;
+      }
+      break;
+    case 3:
+      if(NULL != ppos)
+      {
+        linked_list_node_unlink(hlist, &ppos->node);
+        CHECK_((NULL == ppos->node.pnext_node) && (NULL == ppos->node.pprev_node));
+        model_erase_(pmodel, model_find_(pmodel, ppos->id));
+        ppos->list = -1;
+      }
+      break;
+    case 4:
+    {
+      item_t* pfirst = LINKED_LIST_ENTRY(linked_list_node_remove(hlist), item_t, node);
+      CHECK_((0 == pmodel->len) == (NULL == pfirst));
+      if(NULL != pfirst)
+      {
+        CHECK_(pmodel->id[0] == pfirst->id);
+        model_erase_(pmodel, 0);
+        pfirst->list = -1;
+      }
+      break;
+    }
+    case 5:
+    {
+      /* the other list moves to the end of this one */
+      model_t* psrc = &model_[1 - list];
+      for(size_t i = 0; i < psrc->len; ++i)
+      {
+        item_[psrc->id[i]].list = list;
+        model_insert_(pmodel, pmodel->len, psrc->id[i]);
+      }
+      psrc->len = 0;
+      linked_list_splice(hlist, &list_[1 - list]);
+      break;
+    }
+    default:
+    {
+      /* unlinks every other node while walking, hnext survives it */
+      linked_list_node_t* hnode;
+      linked_list_node_t* hnext;
+      bool drop = (0 != random_(2));
+      LINKED_LIST_FOREACH_SAFE(hlist, hnode, hnext)
+      {
+        if(drop)
+        {
+          item_t* pdrop = LINKED_LIST_CONTAINER_OF(hnode, item_t, node);
+          linked_list_node_unlink(hlist, hnode);
+          model_erase_(pmodel, model_find_(pmodel, pdrop->id));
+          pdrop->list = -1;
+        }
+        drop = !drop;
+      }
+      break;
+    }
+  }
+
+  list_check_(&list_[0], &model_[0]);
+  list_check_(&list_[1], &model_[1]);
+}
+
+/********************** external functions definition ************************/
+
+int main(void)
+{
+  for(uint32_t i = 0; i < ITEMS_; ++i)
+  {
+    item_[i].id = i;
+    item_[i].list = -1;
+    linked_list_node_init(&item_[i].node);
+  }
+  linked_list_init(&list_[0]);
+  linked_list_init(&list_[1]);
+  CHECK_(NULL == linked_list_node_remove(&list_[0]));
+
+  for(uint32_t i = 0; i < STEPS_; ++i)
+  {
+    step_();
+  }
+  printf("linked_list: %u random steps ok\n", STEPS_);
+  return EXIT_SUCCESS;
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2023 Sebastian Bedin <sebabedin@gmail.com>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file   : test_memory_pool.c
+ * @author : Sebastian Bedin <sebabedin@gmail.com>
+ * @version	v1.0.0
+ */
+
+/********************** inclusions *******************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "memory_pool.h"
+
+/********************** macros and definitions *******************************/
+
+#define NBLOCKS_                  (16)
+#define THREADS_                  (8)
+#define ITERATIONS_               (200000)
+#define HELD_MAX_                 (3)
+
+#define CHECK_(cond) \
+  do \
+  { \
+    if(!(cond)) \
+    { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      exit(EXIT_FAILURE); \
+    } \
+  } while(0)
+
+/********************** internal data declaration ****************************/
+
+/* pnext overlays the first word of a free block, owner is never touched by the pool */
+typedef struct
+{
+  void* plink;
+  _Atomic uint32_t owner;
+  uint32_t pattern;
+} block_t;
+
+typedef struct
+{
+  uint32_t id;
+  bool magazine;
+  uint32_t gets;
+  uint32_t failed;
+} worker_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+MEMORY_POOL_DEFINE(pool_, block_t, NBLOCKS_);
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/* a block handed to two owners at once shows up as a non zero owner */
+static void block_claim_(block_t* pblock, uint32_t id)
+{
+  CHECK_(0 == atomic_exchange(&pblock->owner, id));
+  pblock->pattern = id * 2654435761u;
+}
+
+static void block_free_(block_t* pblock, uint32_t id)
+{
+  CHECK_(id * 2654435761u == pblock->pattern);
+  CHECK_(id == atomic_exchange(&pblock->owner, 0));
+}
+
+/*
+ * Every worker keeps up to HELD_MAX_ blocks and frees them in a shuffled
+ * order, half of them through a magazine, so single pops and pushes race
+ * with the batched ones.
+ */
+static void* worker_(void* argument)
+{
+  worker_t* pworker = (worker_t*)argument;
+  memory_pool_magazine_t magazine;
+  block_t* pheld[HELD_MAX_];
+  uint32_t held = 0;
+  uint32_t seed = pworker->id;
+
+  if(pworker->magazine)
+  {
+    memory_pool_magazine_attach(&pool_, &magazine);
+  }
+
+  for(uint32_t i = 0; i < ITERATIONS_; ++i)
+  {
+    seed = seed * 1103515245u + 12345u;
+    if((held < HELD_MAX_) && (0 != (seed & 0x10000u)))
+    {
+      block_t* pblock = memory_pool_block_get(&pool_);
+      if(NULL == pblock)
+      {
+        pworker->failed++;
+        continue;
+      }
+      pworker->gets++;
+      block_claim_(pblock, pworker->id);
+      pheld[held++] = pblock;
+    }
+    else if(0 < held)
+    {
+      uint32_t n = (seed >> 20) % held;
+      block_t* pblock = pheld[n];
+      pheld[n] = pheld[--held];
+      block_free_(pblock, pworker->id);
+      memory_pool_block_put(&pool_, pblock);
+    }
+    if(0 == (i & 0xFFu))
+    {
+      sched_yield();
+    }
+  }
+
+  while(0 < held)
+  {
+    block_t* pblock = pheld[--held];
+    block_free_(pblock, pworker->id);
+    memory_pool_block_put(&pool_, pblock);
+  }
+  memory_pool_magazine_detach();
+  return NULL;
+}
+
+/* single threaded: every block comes back exactly once and the pool is exhausted after NBLOCKS_ */
+static void drain_check_(void)
+{
+  block_t* pblock[NBLOCKS_];
+  for(uint32_t i = 0; i < NBLOCKS_; ++i)
+  {
+    pblock[i] = memory_pool_block_get(&pool_);
+    CHECK_(NULL != pblock[i]);
+    block_claim_(pblock[i], 1000 + i);
+  }
+  CHECK_(NULL == memory_pool_block_get(&pool_));
+  for(uint32_t i = 0; i < NBLOCKS_; ++i)
+  {
+    block_free_(pblock[i], 1000 + i);
+    memory_pool_block_put(&pool_, pblock[i]);
+  }
+}
+
+/********************** external functions definition ************************/
+
+int main(void)
+{
+  pthread_t thread[THREADS_];
+  worker_t worker[THREADS_];
+  uint64_t gets = 0;
+
+  /* the pool stores pointers in 32-bit words, as on the target */
+  CHECK_((uintptr_t)pool__memory_ + sizeof(pool__memory_) <= UINT32_MAX);
+
+  for(uint32_t i = 0; i < THREADS_; ++i)
+  {
+    worker[i] = (worker_t){.id = i + 1, .magazine = (0 != (i & 1u))};
+    CHECK_(0 == pthread_create(&thread[i], NULL, worker_, &worker[i]));
+  }
+  for(uint32_t i = 0; i < THREADS_; ++i)
+  {
+    CHECK_(0 == pthread_join(thread[i], NULL));
+    gets += worker[i].gets;
+  }
+
+  memory_pool_stats_t stats;
+  memory_pool_stats(&pool_, &stats);
+  printf("memory_pool: %u threads, %llu gets, high water %u/%u, %u failed\n",
+         THREADS_, (unsigned long long)gets, stats.high_water, stats.nblocks, stats.failed);
+  CHECK_(0 == stats.in_use);
+  CHECK_(stats.gets == stats.puts);
+  CHECK_((uint32_t)gets == stats.gets);
+  CHECK_(stats.high_water <= NBLOCKS_);
+
+  drain_check_();
+  printf("memory_pool: ok\n");
+  return EXIT_SUCCESS;
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+#
+# Decoder for the tokenized logger (LOGGER_CONFIG_USE_TOKENS = 1).
+#
+# The target only sends [0xA5][nargs][token][timestamp][context][args...]; the format
+# string for a token lives at that offset of the ".logger_fmt" section of the
+# firmware ELF, which is never flashed. "%s" arguments are addresses of strings
+# in flash and are looked up in the loadable sections of the same ELF.
+#
+# usage: logger_decode.py [--clock HZ] firmware.elf [capture.bin]   (reads stdin by default)
+#
+# requires: pip install pyelftools
+
+import argparse
+import re
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+FRAME_SYNC = 0xA5
+FRAME_HEADER_SIZE = 16
+FRAME_MAXARGS = 4       # LOGGER_CONFIG_MAXARGS
+CONTEXT_ISR_MAX = 256
+FMT_SECTION = ".logger_fmt"
+
+SPEC_RE = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|t|j)?([diuxXoscp%])")
+
+
+class Firmware:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            elf = ELFFile(f)
+            fmt = elf.get_section_by_name(FMT_SECTION)
+            if fmt is None:
+                sys.exit("%s: no %s section, build with LOGGER_CONFIG_USE_TOKENS" % (path, FMT_SECTION))
+            self.fmt = fmt.data()
+            self.sections = [(s["sh_addr"], s.data()) for s in elf.iter_sections()
+                             if s["sh_flags"] & 0x2 and s["sh_type"] == "SHT_PROGBITS"]
+
+    @staticmethod
+    def _cstr(data, offset):
+        end = data.find(b"\0", offset)
+        return data[offset:end if end >= 0 else len(data)].decode("ascii", "replace")
+
+    def format_string(self, token):
+        if token >= len(self.fmt):
+            return None
+        return self._cstr(self.fmt, token)
+
+    def string_at(self, address):
+        for base, data in self.sections:
+            if base <= address < base + len(data):
+                return self._cstr(data, address - base)
+        return "<0x%08x>" % address
+
+
+def render(fw, fmt, args):
+    args = list(args)
+
+    def replace(m):
+        flags, width, precision, _, conv = m.groups()
+        if conv == "%":
+            return "%"
+        value = args.pop(0) if args else 0
+        spec = "%" + flags + width + ("." + precision if precision else "")
+        if conv in "di":
+            return (spec + "d") % struct.unpack("<i", struct.pack("<I", value))[0]
+        if conv == "s":
+            return (spec + "s") % fw.string_at(value)
+        if conv == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if conv == "p":
+            return "0x%08x" % value
+        return (spec + conv) % value
+
+    return SPEC_RE.sub(replace, fmt)
+
+
+def frames(stream):
+    buf = b""
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            return
+        buf += chunk
+        while buf and buf[0] != FRAME_SYNC:
+            buf = buf[1:]
+        if len(buf) < FRAME_HEADER_SIZE:
+            continue
+        nargs = buf[1]
+        if nargs > FRAME_MAXARGS:
+            # corrupt header, not a frame: resync on the next sync byte
+            buf = buf[1:]
+            continue
+        size = FRAME_HEADER_SIZE + 4 * nargs
+        if len(buf) < size:
+            continue
+        token, timestamp, context = struct.unpack("<HQI", buf[2:FRAME_HEADER_SIZE])
+        args = struct.unpack("<%dI" % nargs, buf[FRAME_HEADER_SIZE:size])
+        buf = buf[size:]
+        yield token, timestamp, context, args
+
+
+def prefix(timestamp, context, clock):
+    us = timestamp * 1000000 // clock
+    if context == 0:
+        who = "main"
+    elif context < CONTEXT_ISR_MAX:
+        who = "isr %d" % context
+    else:
+        who = "%08x" % context
+    return "[%4d.%06d][%s] " % (us // 1000000, us % 1000000, who)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="tokenized logger decoder")
+    parser.add_argument("--clock", type=int, default=84000000, help="core clock in Hz (default 84 MHz)")
+    parser.add_argument("elf")
+    parser.add_argument("capture", nargs="?")
+    opts = parser.parse_args()
+
+    fw = Firmware(opts.elf)
+    stream = open(opts.capture, "rb") if opts.capture else sys.stdin.buffer
+    for token, timestamp, context, args in frames(stream):
+        fmt = fw.format_string(token)
+        sys.stdout.write(prefix(timestamp, context, opts.clock))
+        if fmt is None:
+            sys.stdout.write("<unknown token 0x%04x %s>\n" % (token, " ".join("0x%08x" % a for a in args)))
+        else:
+            sys.stdout.write(render(fw, fmt, args))
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()